@@ -50,3 +50,15 @@ def run():
     d2d.entityManager.addEntity(e)
 
 
+# possible way to spawn a lot of the same thing at once
+def spawnBullets(origin, count):
+    bullet = d2d.Prefab.load(d2d.Filename.gameFile("prefabs/bullet.xml"))
+    positions = []
+    velocities = []
+    for i in range(count):
+        positions.append(d2d.glm.vec2(origin.x, origin.y))
+        velocities.append(d2d.glm.vec2(200, (i - count / 2) * 10))
+    # ids for d2d.entityManager.destroyEntities
+    return bullet.instantiate(positions, velocities)
+
+
@@ -0,0 +1,162 @@
+/*
+    bench.cpp: tiny benchmark harness
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+BenchState::BenchState(double minTime)
+    : minTime(minTime)
+{
+}
+
+bool BenchState::keepRunning()
+{
+    // nothing should need more than this, but just in case something takes no time at all
+    const size_t maxIterations = 1000000000;
+
+    if (done == batchEnd) {
+        pauseTiming();
+        if (getElapsed() >= minTime || done >= maxIterations) {
+            return false;
+        }
+        batchEnd = done * 2;
+    }
+
+    done++;
+    resumeTiming();
+    return true;
+}
+
+void BenchState::pauseTiming()
+{
+    if (timing) {
+        elapsed += Clock::now() - start;
+        timing = false;
+    }
+}
+
+void BenchState::resumeTiming()
+{
+    if (!timing) {
+        start = Clock::now();
+        timing = true;
+    }
+}
+
+void BenchState::setItemsPerIteration(size_t items)
+{
+    itemsPerIteration = items;
+}
+
+size_t BenchState::getIterations() const
+{
+    return done;
+}
+
+size_t BenchState::getItemsPerIteration() const
+{
+    return itemsPerIteration;
+}
+
+double BenchState::getElapsed() const
+{
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+void BenchRunner::add(const std::string& name, BenchFunction function)
+{
+    benchmarks.push_back(std::make_pair(name, std::move(function)));
+}
+
+int BenchRunner::run(int argc, char* argv[])
+{
+    std::string filter;
+    std::string jsonFile;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        } else if (arg.compare(0, 11, "--min-time=") == 0) {
+            minTime = std::atof(arg.c_str() + 11);
+        } else if (arg.compare(0, 7, "--json=") == 0) {
+            jsonFile = arg.substr(7);
+        } else {
+            fprintf(stderr, "unknown argument %s\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    printf("%-48s %12s %16s %16s\n", "benchmark", "iterations", "ns/iteration", "items/s");
+    for (auto&& benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.first.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        auto result = measure(benchmark.first, benchmark.second);
+        printf("%-48s %12zu %16.1f %16.4g\n", result.name.c_str(), result.iterations, result.nsPerIteration, result.itemsPerSecond);
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (!jsonFile.empty() && !writeJson(jsonFile, results)) {
+        return 1;
+    }
+    return 0;
+}
+
+BenchResult BenchRunner::measure(const std::string& name, const BenchFunction& function) const
+{
+    BenchState state(minTime);
+    function(state);
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = state.getIterations();
+    double elapsed = state.getElapsed();
+    if (result.iterations > 0) {
+        result.nsPerIteration = elapsed * 1e9 / result.iterations;
+    }
+    if (elapsed > 0.0) {
+        result.itemsPerSecond = static_cast<double>(result.iterations * state.getItemsPerIteration()) / elapsed;
+    }
+    return result;
+}
+
+bool BenchRunner::writeJson(const std::string& filename, const std::vector<BenchResult>& results) const
+{
+    std::ofstream file(filename);
+    if (!file) {
+        fprintf(stderr, "cannot write %s\n", filename.c_str());
+        return false;
+    }
+
+    file << "{\n  \"context\": {\"executable\": \"d2d_bench\", \"min_time\": " << minTime << "},\n";
+    file << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        // names are ours, no escaping needed
+        file << "    {\"name\": \"" << result.name << "\", \"run_type\": \"iteration\""
+             << ", \"iterations\": " << result.iterations
+             << ", \"real_time\": " << result.nsPerIteration
+             << ", \"time_unit\": \"ns\""
+             << ", \"items_per_second\": " << result.itemsPerSecond << "}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    return true;
+}
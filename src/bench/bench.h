@@ -0,0 +1,88 @@
+/*
+    bench.h: tiny benchmark harness
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _bench_bench_h
+#define _bench_bench_h
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Handed to every benchmark. Setup goes first, the measured part into a while (state.keepRunning()) loop.
+// The loop goes around in batches of doubling size until the measured time reaches minTime,
+// so the clock is only read at batch ends and the setup only runs once.
+class BenchState {
+public:
+    explicit BenchState(double minTime);
+
+    bool keepRunning();
+    // for setup inside the loop. a pause lasts until resumeTiming or the next iteration
+    void pauseTiming();
+    void resumeTiming();
+
+    // how much work one iteration is (elements inserted etc), for items per second
+    void setItemsPerIteration(size_t items);
+
+    size_t getIterations() const;
+    size_t getItemsPerIteration() const;
+    // in seconds, without the paused parts
+    double getElapsed() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double minTime;
+    size_t done = 0;
+    size_t batchEnd = 1;
+    size_t itemsPerIteration = 1;
+    bool timing = false;
+    Clock::time_point start;
+    Clock::duration elapsed = Clock::duration::zero();
+};
+
+using BenchFunction = std::function<void(BenchState&)>;
+
+struct BenchResult {
+    std::string name;
+    size_t iterations = 0;
+    double nsPerIteration = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+// Runs the benchmarks one after another, each of them once
+class BenchRunner {
+public:
+    void add(const std::string& name, BenchFunction function);
+
+    // --filter=text only runs names containing text, --min-time=seconds,
+    // --json=file also writes the results as json, laid out like google benchmark does it
+    // returns the exit code
+    int run(int argc, char* argv[]);
+
+private:
+    BenchResult measure(const std::string& name, const BenchFunction& function) const;
+    bool writeJson(const std::string& filename, const std::vector<BenchResult>& results) const;
+
+    std::vector<std::pair<std::string, BenchFunction>> benchmarks;
+    double minTime = 0.25;
+};
+
+// the suites
+void addSlotMapBenchmarks(BenchRunner& runner);
+void addSystemBenchmarks(BenchRunner& runner);
+
+#endif // _bench_bench_h
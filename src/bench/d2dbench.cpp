@@ -0,0 +1,54 @@
+/*
+    d2dbench.cpp: engine benchmark suite
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "bench.h"
+
+#include "runtime/filename.h"
+#include "runtime/window.h"
+#include "systems/init.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+// The engine systems without a window, the same way --headless runs them.
+// d2d_bench --filter=Collision --json=results.json
+int main(int argc, char* argv[])
+{
+    Window::headless = true;
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Cannot Init SDL! %s", SDL_GetError());
+        return 1;
+    }
+    IMG_Init(IMG_INIT_PNG);
+
+    // generated maps and images go where the engine writes its config
+    char* prefPath = SDL_GetPrefPath("dragon2d", "bench");
+    Filename::writeablePath = std::string(prefPath);
+    SDL_free(prefPath);
+
+    initSystems();
+
+    BenchRunner runner;
+    addSlotMapBenchmarks(runner);
+    addSystemBenchmarks(runner);
+    int result = runner.run(argc, argv);
+
+    finishSystemsEarly();
+    finishSystems();
+
+    IMG_Quit();
+    SDL_Quit();
+    return result;
+}
@@ -0,0 +1,116 @@
+/*
+    slotmapbench.cpp: slot map memory layout micro benchmark
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/slotmap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// the slot layout before generations moved into their own array
+template <class T>
+struct LegacyStorageType {
+    bool free;
+    uint32_t generation;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+    T* ptr;
+};
+
+template <class T, size_t baseSize>
+struct LegacyChunk {
+    std::array<LegacyStorageType<T>, baseSize> data;
+    size_t size = 0;
+};
+
+// stand-ins with the size of the usual payloads
+struct Payload8 {
+    uint64_t a;
+};
+
+struct Payload32 {
+    float v[8];
+};
+
+struct Payload48 {
+    double v[6];
+};
+
+template <class T, size_t baseSize = 256>
+void printLayout(const char* name)
+{
+    double before = static_cast<double>(sizeof(LegacyChunk<T, baseSize>)) / baseSize;
+    double after = static_cast<double>(sizeof(typename SlotMap<T, baseSize>::Chunk)) / baseSize;
+    printf("%-24s payload %3zu B   before %6.2f B/elem   after %6.2f B/elem   overhead %5.2f -> %5.2f B\n",
+        name,
+        sizeof(T),
+        before,
+        after,
+        before - sizeof(T),
+        after - sizeof(T));
+}
+
+template <class T>
+void iterate(const char* name, size_t count, size_t keepEvery)
+{
+    SlotMap<T> map;
+    std::vector<SlotMapIndex> indices;
+    indices.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        indices.push_back(map.insert(T()));
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (i % keepEvery != 0) {
+            map.remove(indices[i]);
+        }
+    }
+
+    const int runs = 100;
+    size_t visited = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int run = 0; run < runs; run++) {
+        for (auto&& value : map) {
+            (void)value;
+            ++visited;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / runs;
+    printf("%-24s %8zu slots, 1/%-3zu live   %10.0f ns/iteration   %6.2f ns/live elem\n",
+        name,
+        count,
+        keepEvery,
+        ns,
+        ns / (visited / runs));
+}
+
+int main()
+{
+    printf("== bytes per element\n");
+    printLayout<Payload8>("SlotMapIndex-sized");
+    printLayout<Payload8, 32>("SlotMapIndex-sized, 32");
+    printLayout<Payload32>("Collider-sized");
+    printLayout<Payload48>("Transform2D-sized");
+    printLayout<std::string>("std::string");
+
+    printf("== iteration\n");
+    iterate<Payload32>("Collider-sized", 100000, 1);
+    iterate<Payload32>("Collider-sized", 100000, 16);
+    iterate<Payload32>("Collider-sized", 100000, 256);
+    iterate<Payload48>("Transform2D-sized", 100000, 1);
+    iterate<Payload48>("Transform2D-sized", 100000, 16);
+    iterate<Payload48>("Transform2D-sized", 100000, 256);
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+    slotmapbenches.cpp: slot map throughput benchmarks
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "bench.h"
+
+#include "util/slotmap.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+// about the size of a collider
+struct Payload {
+    float v[8];
+};
+
+const size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+
+std::vector<SlotMapIndex> fill(SlotMap<Payload>& map, size_t count)
+{
+    std::vector<SlotMapIndex> indices;
+    indices.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        indices.push_back(map.insert(Payload()));
+    }
+    return indices;
+}
+
+void insert(BenchState& state, size_t count)
+{
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        SlotMap<Payload> map;
+        for (size_t i = 0; i < count; i++) {
+            map.insert(Payload());
+        }
+        // the destructor does not count
+        state.pauseTiming();
+    }
+}
+
+void remove(BenchState& state, size_t count)
+{
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        SlotMap<Payload> map;
+        auto indices = fill(map, count);
+        // not in insertion order, thats the easy case
+        std::shuffle(indices.begin(), indices.end(), std::mt19937(1234));
+        state.resumeTiming();
+
+        for (auto&& index : indices) {
+            map.remove(index);
+        }
+        state.pauseTiming();
+    }
+}
+
+void removeMany(BenchState& state, size_t count)
+{
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        SlotMap<Payload> map;
+        auto indices = fill(map, count);
+        std::shuffle(indices.begin(), indices.end(), std::mt19937(1234));
+        state.resumeTiming();
+
+        map.removeMany(indices);
+        state.pauseTiming();
+    }
+}
+
+// every keepEvery-th element survives
+void iterate(BenchState& state, size_t count, size_t keepEvery)
+{
+    SlotMap<Payload> map;
+    auto indices = fill(map, count);
+    for (size_t i = 0; i < count; i++) {
+        if (i % keepEvery != 0) {
+            map.remove(indices[i]);
+        }
+    }
+
+    state.setItemsPerIteration((count + keepEvery - 1) / keepEvery);
+    float sum = 0.0f;
+    while (state.keepRunning()) {
+        for (auto&& value : map) {
+            sum += value.v[0];
+        }
+    }
+    // so the loop does not go away
+    if (sum != 0.0f) {
+        printf("%f\n", sum);
+    }
+}
+}
+
+void addSlotMapBenchmarks(BenchRunner& runner)
+{
+    for (size_t count : sizes) {
+        std::string suffix = "/" + std::to_string(count);
+        runner.add("SlotMap/insert" + suffix, [count](BenchState& state) { insert(state, count); });
+        runner.add("SlotMap/remove" + suffix, [count](BenchState& state) { remove(state, count); });
+        runner.add("SlotMap/removeMany" + suffix, [count](BenchState& state) { removeMany(state, count); });
+        runner.add("SlotMap/iterate" + suffix, [count](BenchState& state) { iterate(state, count, 1); });
+        runner.add("SlotMap/iterateSparse" + suffix, [count](BenchState& state) { iterate(state, count, 16); });
+    }
+}
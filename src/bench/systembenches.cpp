@@ -0,0 +1,343 @@
+/*
+    systembenches.cpp: system update benchmarks
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "bench.h"
+
+#include "runtime/filename.h"
+#include "systems/animation.h"
+#include "systems/collision.h"
+#include "systems/input.h"
+#include "systems/render.h"
+#include "systems/simplephysics.h"
+#include "systems/spriterenderer.h"
+#include "systems/transform.h"
+#include "util/tiled/tmx.h"
+
+#include <SDL.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace {
+// Everything a benchmark created, removed again at the end so the next one starts from empty systems.
+// Works on the system instances directly, no entities and no python.
+struct World {
+    std::vector<TransformSystem::IndexType> transforms;
+    std::vector<CollisionSystem::IndexType> colliders;
+    std::vector<SimplePhysicsSystem::IndexType> bodies;
+    std::vector<RenderSystem::IndexType> sprites;
+    std::vector<AnimationSystem::IndexType> animations;
+
+    ~World()
+    {
+        AnimationSystem::instance->removeMany(animations);
+        RenderSystem::instance->removeSprites(sprites);
+        SimplePhysicsSystem::instance->removeMany(bodies);
+        CollisionSystem::instance->removeMany(colliders);
+        TransformSystem::instance->removeMany(transforms);
+    }
+
+    // count transforms spread over a square with about density of them per collision cell (100x100)
+    void scatter(size_t count, float density)
+    {
+        float side = 100.0f * std::sqrt(static_cast<float>(count) / density);
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> coordinate(0.0f, side);
+        transforms.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            transforms.push_back(TransformSystem::instance->create(glm::vec2(coordinate(random), coordinate(random))));
+        }
+    }
+
+    void addColliders()
+    {
+        for (auto&& transform : transforms) {
+            colliders.push_back(CollisionSystem::instance->create(transform, FRect(0.0f, 0.0f, 32.0f, 32.0f)));
+        }
+    }
+
+    void addBodies(bool collision)
+    {
+        std::mt19937 random(4321);
+        std::uniform_real_distribution<float> speed(-100.0f, 100.0f);
+        for (size_t i = 0; i < transforms.size(); i++) {
+            CollisionSystem::IndexType collider = collision ? colliders[i] : CollisionSystem::IndexType();
+            bodies.push_back(SimplePhysicsSystem::instance->create(transforms[i], collider, collision));
+            auto& body = SimplePhysicsSystem::instance->get(bodies.back());
+            body.velocity = glm::vec2(speed(random), speed(random));
+            body.gravity = glm::vec2(0.0f, 10.0f);
+            body.maxVelocity = glm::vec2(200.0f);
+        }
+    }
+};
+
+const double step = 1.0 / 60.0;
+
+// generated once per run, next to the other writeable files
+std::string spriteFile()
+{
+    static std::string filename;
+    if (filename.empty()) {
+        filename = Filename::configFile("bench_sprite.bmp");
+        auto surface = SDL_CreateRGBSurfaceWithFormat(0, 256, 256, 32, SDL_PIXELFORMAT_RGBA32);
+        SDL_SaveBMP(surface, filename.c_str());
+        SDL_FreeSurface(surface);
+    }
+    return filename;
+}
+
+std::string animationFile()
+{
+    static std::string filename;
+    if (filename.empty()) {
+        filename = Filename::configFile("bench_animation.xml");
+        AnimatedSprite sprite;
+        Animation walk;
+        walk.name = "walk";
+        walk.loop = true;
+        for (int i = 0; i < 8; i++) {
+            Frame frame;
+            // uneven durations, so not every sprite flips frames in the same step
+            frame.duration = 0.05 + 0.01 * i;
+            frame.src = Rect(i * 32, 0, 32, 32);
+            walk.frames.push_back(frame);
+        }
+        sprite.animations.push_back(walk);
+        sprite.save(filename);
+    }
+    return filename;
+}
+
+// infinite map (thats what Tmx reads) of size x size tiles in 16x16 chunks, csv encoded
+std::string mapFile(int size)
+{
+    std::string tilesetName = "bench_tiles.tsx";
+    std::ofstream tileset(Filename::configFile(tilesetName));
+    tileset << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<tileset version=\"1.2\" name=\"bench\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"64\" columns=\"8\">\n"
+            << "<image source=\"bench_sprite.bmp\" width=\"256\" height=\"256\"/>\n"
+            << "</tileset>\n";
+
+    std::string filename = Filename::configFile("bench_map_" + std::to_string(size) + ".tmx");
+    std::ofstream map(filename);
+    map << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<map version=\"1.2\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"" << size << "\" height=\"" << size
+        << "\" tilewidth=\"32\" tileheight=\"32\" infinite=\"1\">\n"
+        << "<tileset firstgid=\"1\" source=\"" << tilesetName << "\"/>\n";
+    for (int layer = 0; layer < 2; layer++) {
+        map << "<layer id=\"" << layer + 1 << "\" name=\"layer" << layer << "\" width=\"" << size << "\" height=\"" << size << "\">\n"
+            << "<data encoding=\"csv\">\n";
+        for (int y = 0; y < size; y += 16) {
+            for (int x = 0; x < size; x += 16) {
+                map << "<chunk x=\"" << x << "\" y=\"" << y << "\" width=\"16\" height=\"16\">\n";
+                for (int i = 0; i < 256; i++) {
+                    // the upper layer is mostly empty, like decoration usually is
+                    int gid = layer == 0 || (x + y + i) % 7 == 0 ? 1 + (x + y + i) % 64 : 0;
+                    map << gid << (i == 255 ? "\n" : ",");
+                }
+                map << "</chunk>\n";
+            }
+        }
+        map << "</data>\n</layer>\n";
+    }
+    map << "</map>\n";
+    return filename;
+}
+
+void collisionUpdate(BenchState& state, size_t count, float density)
+{
+    World world;
+    world.scatter(count, density);
+    world.addColliders();
+
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        CollisionSystem::instance->update(step);
+    }
+}
+
+void collisionCheck(BenchState& state, size_t count, float density)
+{
+    World world;
+    world.scatter(count, density);
+    world.addColliders();
+    CollisionSystem::instance->update(step);
+
+    state.setItemsPerIteration(count);
+    size_t hits = 0;
+    while (state.keepRunning()) {
+        for (auto&& collider : world.colliders) {
+            hits += CollisionSystem::instance->checkCollision(collider) ? 1 : 0;
+        }
+    }
+    if (hits == 1) {
+        printf("one hit\n");
+    }
+}
+
+void physicsFree(BenchState& state, size_t count)
+{
+    World world;
+    world.scatter(count, 4.0f);
+    world.addBodies(false);
+
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        SimplePhysicsSystem::instance->update(step);
+    }
+}
+
+// a whole fixed step: the collision grid, then the physics that use it
+void physicsColliding(BenchState& state, size_t count)
+{
+    World world;
+    world.scatter(count, 4.0f);
+    world.addColliders();
+    world.addBodies(true);
+
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        CollisionSystem::instance->update(step);
+        SimplePhysicsSystem::instance->update(step);
+    }
+}
+
+void animationUpdate(BenchState& state, size_t count)
+{
+    World world;
+    world.scatter(count, 4.0f);
+
+    RenderSystem::TextureIndexType texture;
+    if (!RenderSystem::instance->loadTexture(spriteFile(), texture)) {
+        return;
+    }
+    for (auto&& transform : world.transforms) {
+        world.sprites.push_back(RenderSystem::instance->createSprite(transform, texture, 0));
+        world.animations.push_back(AnimationSystem::instance->create(world.sprites.back(), animationFile()));
+        AnimationSystem::instance->get(world.animations.back()).play("walk");
+    }
+
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        AnimationSystem::instance->update(step);
+    }
+}
+
+// the cpu side of the gl sprite renderer: vertices for rotated and flipped sprites. no context, so nothing is drawn
+void spriteVertices(BenchState& state, size_t count)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::vector<DrawItem> items(count);
+    for (size_t i = 0; i < count; i++) {
+        items[i].source = { 0, 0, 16, 16 };
+        items[i].destination = { position(random), position(random), 16.0f, 16.0f };
+        items[i].rotation = (i % 4) ? 0.0 : 45.0;
+        items[i].flip = (i % 2) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+    }
+
+    GLSpriteRenderer renderer;
+    SDL_Rect viewport = { 0, 0, 1280, 720 };
+    state.setItemsPerIteration(count);
+    while (state.keepRunning()) {
+        renderer.add(1, 256, 256, 0, viewport, items.data(), items.size());
+        renderer.flush();
+    }
+}
+
+void tmxParse(BenchState& state, int size)
+{
+    spriteFile();
+    std::string filename = mapFile(size);
+
+    state.setItemsPerIteration(static_cast<size_t>(size) * size * 2);
+    size_t layers = 0;
+    while (state.keepRunning()) {
+        Tmx map(filename);
+        layers += map.layers.size();
+        // freeing all those tiles is not parsing
+        state.pauseTiming();
+    }
+    if (layers == 0) {
+        printf("map did not load\n");
+    }
+}
+
+// handlers callbacks listen to "keydown", "keyup" and "jump" (mapped from space) each.
+// a key press and release, so two events per iteration
+void inputDispatch(BenchState& state, size_t handlers)
+{
+    auto& input = *InputSystem::instance;
+    XmlInput jump;
+    jump.name = "jump";
+    jump.origParam = SDLK_SPACE;
+    jump.newParam = 1;
+    auto loaded = input.getLoadedInputs().insert(std::make_pair(std::string("keydown"), jump));
+
+    size_t calls = 0;
+    InputFunction callback = [&calls](const std::string&, int64_t) { calls++; };
+    std::vector<InputSystem::IndexType> indices;
+    const char* names[] = { "keydown", "keyup", "jump" };
+    for (size_t i = 0; i < handlers; i++) {
+        indices.push_back(input.create(names[i % 3], callback));
+    }
+
+    SDL_Event down = {};
+    down.type = SDL_KEYDOWN;
+    down.key.keysym.sym = SDLK_SPACE;
+    SDL_Event up = down;
+    up.type = SDL_KEYUP;
+
+    state.setItemsPerIteration(2);
+    while (state.keepRunning()) {
+        input.processEvent(down);
+        input.processEvent(up);
+    }
+
+    input.removeMany(indices);
+    input.getLoadedInputs().erase(loaded);
+}
+}
+
+void addSystemBenchmarks(BenchRunner& runner)
+{
+    // density is colliders per collision grid cell
+    for (size_t count : { 1000, 10000 }) {
+        for (float density : { 1.0f, 8.0f, 32.0f }) {
+            std::string suffix = "/" + std::to_string(count) + "/density:" + std::to_string(static_cast<int>(density));
+            runner.add("Collision/update" + suffix, [count, density](BenchState& state) { collisionUpdate(state, count, density); });
+            runner.add("Collision/checkCollision" + suffix, [count, density](BenchState& state) { collisionCheck(state, count, density); });
+        }
+    }
+
+    for (size_t count : { 1000, 10000, 100000 }) {
+        std::string suffix = "/" + std::to_string(count);
+        runner.add("SimplePhysics/update" + suffix, [count](BenchState& state) { physicsFree(state, count); });
+        runner.add("Animation/update" + suffix, [count](BenchState& state) { animationUpdate(state, count); });
+        runner.add("GLSpriteRenderer/add" + suffix, [count](BenchState& state) { spriteVertices(state, count); });
+    }
+    for (size_t count : { 1000, 10000 }) {
+        runner.add("SimplePhysics/updateColliding/" + std::to_string(count), [count](BenchState& state) { physicsColliding(state, count); });
+    }
+
+    for (int size : { 64, 256, 1024 }) {
+        runner.add("Tmx/parse/" + std::to_string(size) + "x" + std::to_string(size), [size](BenchState& state) { tmxParse(state, size); });
+    }
+
+    for (size_t handlers : { 1, 16, 256 }) {
+        runner.add("Input/processEvent/" + std::to_string(handlers), [handlers](BenchState& state) { inputDispatch(state, handlers); });
+    }
+}
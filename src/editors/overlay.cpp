@@ -19,12 +19,14 @@
 
 #include "inputeditor.h"
 #include "animationeditor.h"
+#include "profilereditor.h"
 
 Overlay::Overlay()
     : visible(false)
 {
     editors.push_back(std::make_shared<InputEditor>());
     editors.push_back(std::make_shared<AnimationEditor>());
+    editors.push_back(std::make_shared<ProfilerEditor>());
 }
 
 void Overlay::update(double dt)
@@ -0,0 +1,173 @@
+/*
+    profilereditor.cpp: frame timeline and timings per zone
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "profilereditor.h"
+
+#include <SDL.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <functional>
+#include <imgui.h>
+#include <string>
+
+#include "runtime/filename.h"
+#include "runtime/profiler.h"
+
+// same name, same color, every frame
+static ImU32 zoneColor(const char* name)
+{
+    size_t hash = std::hash<std::string>()(name);
+    float hue = static_cast<float>(hash % 1024) / 1024.0f;
+    return ImColor::HSV(hue, 0.5f, 0.6f);
+}
+
+ProfilerEditor::ProfilerEditor()
+{
+}
+
+void ProfilerEditor::update(double dt)
+{
+    if (!showProfiler) {
+        return;
+    }
+    ImGui::Begin("Profiler", &showProfiler);
+
+    bool recording = Profiler::isEnabled();
+    if (ImGui::Checkbox("Record", &recording)) {
+        Profiler::setEnabled(recording);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace")) {
+        exportTrace();
+    }
+
+    size_t count = Profiler::frameCount();
+    if (count == 0) {
+        ImGui::Text("Nothing recorded yet");
+        ImGui::End();
+        return;
+    }
+
+    // oldest first, so the graph scrolls to the left
+    frameTimes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const auto& frame = Profiler::frame(i);
+        frameTimes[i] = static_cast<float>(Profiler::toMilliseconds(frame.end - frame.start));
+    }
+    ImGui::PlotLines("Frame", frameTimes.data(), static_cast<int>(count), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+    // while recording always the newest frame, pause to look at older ones
+    int newest = static_cast<int>(count - 1);
+    if (recording) {
+        selectedFrame = newest;
+    } else {
+        selectedFrame = std::min(selectedFrame, newest);
+        ImGui::SliderInt("Frame Index", &selectedFrame, 0, newest);
+    }
+
+    const auto& frame = Profiler::frame(selectedFrame);
+    ImGui::Text("%.3f ms, %zu scopes", frameTimes[selectedFrame], frame.events.size());
+    drawTimeline(frame);
+    drawZones();
+
+    ImGui::End();
+}
+
+void ProfilerEditor::menu()
+{
+    if (ImGui::BeginMenu("Profiler")) {
+        if (ImGui::MenuItem("Show")) {
+            showProfiler = true;
+        }
+        if (ImGui::MenuItem("Export Chrome Trace")) {
+            exportTrace();
+        }
+        ImGui::EndMenu();
+    }
+}
+
+void ProfilerEditor::drawTimeline(const ProfileFrame& frame)
+{
+    if (frame.end <= frame.start) {
+        return;
+    }
+
+    // one band per thread, one row per nesting depth within the band
+    uint32_t threads = 1;
+    uint32_t depth = 1;
+    for (auto&& event : frame.events) {
+        threads = std::max(threads, event.thread + 1);
+        depth = std::max(depth, event.depth + 1);
+    }
+
+    float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    float width = ImGui::GetContentRegionAvail().x;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::Dummy(ImVec2(width, rowHeight * threads * depth));
+
+    auto* drawList = ImGui::GetWindowDrawList();
+    double frameTicks = static_cast<double>(frame.end - frame.start);
+    for (auto&& event : frame.events) {
+        float x0 = origin.x + width * static_cast<float>((event.start - frame.start) / frameTicks);
+        float x1 = origin.x + width * static_cast<float>((event.end - frame.start) / frameTicks);
+        // so even the tiny ones can be hovered
+        x1 = std::max(x1, x0 + 1.0f);
+        float y0 = origin.y + rowHeight * (event.thread * depth + event.depth);
+        ImVec2 min(x0, y0);
+        ImVec2 max(x1, y0 + rowHeight - 1.0f);
+
+        drawList->AddRectFilled(min, max, zoneColor(event.name));
+        drawList->PushClipRect(min, max, true);
+        drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32_WHITE, event.name);
+        drawList->PopClipRect();
+
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+            ImGui::SetTooltip("%s: %.3f ms (thread %u)", event.name, Profiler::toMilliseconds(event.end - event.start), event.thread);
+        }
+    }
+}
+
+void ProfilerEditor::drawZones()
+{
+    if (!ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen)) {
+        return;
+    }
+
+    // the graphs start at the oldest frame of the ring
+    int offset = static_cast<int>(Profiler::historyPosition(0));
+    size_t newest = Profiler::historyPosition(Profiler::frameCount() - 1);
+
+    // sorted by name, so they dont jump around
+    std::vector<const Profiler::Zone*> zones;
+    for (auto&& zone : Profiler::getZones()) {
+        zones.push_back(&zone);
+    }
+    std::sort(zones.begin(), zones.end(), [](const Profiler::Zone* a, const Profiler::Zone* b) {
+        return a->name < b->name;
+    });
+
+    char overlay[64];
+    for (auto&& zone : zones) {
+        const auto& milliseconds = zone->milliseconds;
+        float worst = *std::max_element(milliseconds.begin(), milliseconds.end());
+        snprintf(overlay, sizeof(overlay), "%.3f ms (worst %.3f ms)", milliseconds[newest], worst);
+        ImGui::PlotLines(zone->name.c_str(), milliseconds.data(), static_cast<int>(milliseconds.size()), offset, overlay, 0.0f, FLT_MAX, ImVec2(0, 40));
+    }
+}
+
+void ProfilerEditor::exportTrace()
+{
+    Profiler::exportChromeTrace(Filename::configFile("profile.json"));
+}
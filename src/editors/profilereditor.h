@@ -0,0 +1,42 @@
+/*
+    profilereditor.h: frame timeline and timings per zone
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _editors_profilereditor_h
+#define _editors_profilereditor_h
+
+#include "editor.h"
+
+#include <vector>
+
+struct ProfileFrame;
+
+// what Profiler recorded: a timeline of one frame, and a graph per zone over the whole history
+class ProfilerEditor : public Editor {
+public:
+    ProfilerEditor();
+    virtual void update(double dt) override;
+    virtual void menu() override;
+
+private:
+    void drawTimeline(const ProfileFrame& frame);
+    void drawZones();
+    void exportTrace();
+
+    bool showProfiler = false;
+    // only used while not recording, otherwise it follows the newest frame
+    int selectedFrame = 0;
+    std::vector<float> frameTimes;
+};
+
+#endif //_editors_profilereditor_h
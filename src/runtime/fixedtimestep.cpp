@@ -0,0 +1,76 @@
+/*
+    fixedtimestep.cpp: fixed simulation steps decoupled from the frame rate
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "fixedtimestep.h"
+
+#include <algorithm>
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double step, int maxSteps)
+    : step(step)
+    , maxSteps(maxSteps)
+{
+}
+
+int FixedTimestep::advance(double frameTime)
+{
+    accumulator += std::max(frameTime, 0.0);
+
+    int steps = 0;
+    while (accumulator >= step && steps < maxSteps) {
+        accumulator -= step;
+        steps++;
+    }
+
+    // spiral of death protection: catch up what we can, forget the rest
+    if (accumulator >= step) {
+        double kept = std::fmod(accumulator, step);
+        droppedTime += accumulator - kept;
+        accumulator = kept;
+    }
+
+    return steps;
+}
+
+double FixedTimestep::getAlpha() const
+{
+    return accumulator / step;
+}
+
+double FixedTimestep::getStep() const
+{
+    return step;
+}
+
+void FixedTimestep::setStep(double newStep)
+{
+    if (newStep > 0.0) {
+        step = newStep;
+    }
+}
+
+int FixedTimestep::getMaxSteps() const
+{
+    return maxSteps;
+}
+
+void FixedTimestep::setMaxSteps(int newMaxSteps)
+{
+    maxSteps = std::max(newMaxSteps, 1);
+}
+
+double FixedTimestep::getDroppedTime() const
+{
+    return droppedTime;
+}
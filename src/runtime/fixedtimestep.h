@@ -0,0 +1,47 @@
+/*
+    fixedtimestep.h: fixed simulation steps decoupled from the frame rate
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _runtime_fixedtimestep_h
+#define _runtime_fixedtimestep_h
+
+// Accumulates frame time and hands it out in steps of a fixed size.
+// Whatever is left over is the interpolation factor between the last two steps.
+// If a frame needs more than maxSteps steps, the rest is dropped so a slow frame
+// does not make the next one even slower.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double step = 1.0 / 60.0, int maxSteps = 5);
+
+    // add a frame worth of time. returns how many steps to run now
+    int advance(double frameTime);
+
+    // how far between the previous and the current step we are, 0 to 1
+    double getAlpha() const;
+
+    double getStep() const;
+    void setStep(double step);
+    int getMaxSteps() const;
+    void setMaxSteps(int maxSteps);
+
+    // simulation time thrown away because of maxSteps so far
+    double getDroppedTime() const;
+
+private:
+    double step;
+    int maxSteps;
+    double accumulator = 0.0;
+    double droppedTime = 0.0;
+};
+
+#endif // _runtime_fixedtimestep_h
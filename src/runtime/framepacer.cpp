@@ -0,0 +1,131 @@
+/*
+    framepacer.cpp: keeps frames at a target rate
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "framepacer.h"
+
+#include <SDL.h>
+#include <algorithm>
+
+FramePacer::FramePacer(double targetRate)
+    : targetRate(0.0)
+    , frequency(SDL_GetPerformanceFrequency())
+    , period(0)
+    , spinTicks(0)
+    , frameStart(SDL_GetPerformanceCounter())
+    , deadline(0)
+{
+    setTargetRate(targetRate);
+    setSpinTime(0.002);
+    deadline = frameStart + period;
+}
+
+double FramePacer::endFrame()
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    FrameTiming timing;
+    timing.work = toSeconds(now - frameStart);
+
+    if (period && now < deadline) {
+        // coarse sleep, whole milliseconds only and leaving the spin time
+        if (deadline - now > spinTicks) {
+            uint64_t sleepTicks = deadline - now - spinTicks;
+            auto ms = static_cast<Uint32>(sleepTicks * 1000 / frequency);
+            if (ms > 0) {
+                SDL_Delay(ms);
+            }
+        }
+        // and the rest on the counter
+        now = SDL_GetPerformanceCounter();
+        while (now < deadline) {
+            now = SDL_GetPerformanceCounter();
+        }
+    }
+
+    timing.late = period && now > deadline ? toSeconds(now - deadline) : 0.0;
+    timing.total = toSeconds(now - frameStart);
+
+    // a frame that missed its deadline by more than a whole period starts fresh,
+    // everything else keeps the cadence
+    if (period && now - deadline < period) {
+        frameStart = deadline;
+    } else {
+        frameStart = now;
+    }
+    deadline = frameStart + period;
+
+    history[historyNext] = timing;
+    historyNext = (historyNext + 1) % historySize;
+    historyCount = std::min(historyCount + 1, historySize);
+
+    return timing.total;
+}
+
+void FramePacer::setTargetRate(double rate)
+{
+    targetRate = std::max(rate, 0.0);
+    period = targetRate > 0.0 ? static_cast<uint64_t>(static_cast<double>(frequency) / targetRate) : 0;
+    deadline = frameStart + period;
+}
+
+double FramePacer::getTargetRate() const
+{
+    return targetRate;
+}
+
+void FramePacer::setSpinTime(double seconds)
+{
+    spinTicks = static_cast<uint64_t>(std::max(seconds, 0.0) * static_cast<double>(frequency));
+}
+
+const std::array<FrameTiming, FramePacer::historySize>& FramePacer::getHistory() const
+{
+    return history;
+}
+
+size_t FramePacer::getHistoryStart() const
+{
+    return historyCount < historySize ? 0 : historyNext;
+}
+
+const FrameTiming& FramePacer::getLastFrame() const
+{
+    return history[(historyNext + historySize - 1) % historySize];
+}
+
+double FramePacer::getAverageFrameTime() const
+{
+    if (!historyCount) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < historyCount; i++) {
+        sum += history[i].total;
+    }
+    return sum / static_cast<double>(historyCount);
+}
+
+double FramePacer::getMaxFrameTime() const
+{
+    double result = 0.0;
+    for (size_t i = 0; i < historyCount; i++) {
+        result = std::max(result, history[i].total);
+    }
+    return result;
+}
+
+double FramePacer::toSeconds(uint64_t ticks) const
+{
+    return static_cast<double>(ticks) / static_cast<double>(frequency);
+}
@@ -0,0 +1,73 @@
+/*
+    framepacer.h: keeps frames at a target rate
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _runtime_framepacer_h
+#define _runtime_framepacer_h
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct FrameTiming {
+    // from the start of the frame until endFrame was called
+    double work = 0.0;
+    // start to start, what the next frame gets as dt
+    double total = 0.0;
+    // how far past the deadline the frame ended. sleeping too long, or just a slow frame
+    double late = 0.0;
+};
+
+// Waits for the end of each frame with a fixed deadline.
+// SDL_Delay only does milliseconds and likes to oversleep, so it sleeps until shortly before
+// the deadline and spins on the performance counter for the rest.
+// Deadlines are spaced by the period, not by whenever the last frame ended, so small errors do not add up.
+class FramePacer {
+public:
+    static constexpr size_t historySize = 256;
+
+    // 0 = no limit
+    explicit FramePacer(double targetRate = 120.0);
+
+    // once per frame, after everything is drawn. returns the length of the frame (the dt for the next one)
+    double endFrame();
+
+    void setTargetRate(double rate);
+    double getTargetRate() const;
+    // how long before the deadline sleeping stops and spinning starts
+    void setSpinTime(double seconds);
+
+    // the last historySize frames, oldest first at getHistoryStart()
+    const std::array<FrameTiming, historySize>& getHistory() const;
+    size_t getHistoryStart() const;
+    const FrameTiming& getLastFrame() const;
+    // over the history
+    double getAverageFrameTime() const;
+    double getMaxFrameTime() const;
+
+private:
+    double toSeconds(uint64_t ticks) const;
+
+    double targetRate;
+    uint64_t frequency;
+    uint64_t period;
+    uint64_t spinTicks;
+    uint64_t frameStart;
+    uint64_t deadline;
+
+    std::array<FrameTiming, historySize> history;
+    size_t historyNext = 0;
+    size_t historyCount = 0;
+};
+
+#endif // _runtime_framepacer_h
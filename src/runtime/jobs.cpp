@@ -0,0 +1,289 @@
+/*
+    jobs.cpp: work stealing job system
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "jobs.h"
+
+#include "SDL.h"
+#include <algorithm>
+#include <exception>
+
+struct JobState {
+    JobSystem::Task task;
+    JobAffinity affinity = JobAffinity::Any;
+    // unfinished dependencies, +1 while the job is still being wired up
+    std::atomic<int> blockers { 1 };
+    std::atomic<bool> finished { false };
+    std::mutex mutex; // for continuations
+    std::vector<std::shared_ptr<JobState>> continuations;
+};
+
+std::shared_ptr<JobSystem> JobSystem::instance(nullptr);
+
+// index into the queues. everything that is not a worker shares the last one
+static thread_local size_t currentQueue = static_cast<size_t>(-1);
+
+JobHandle::JobHandle(std::shared_ptr<JobState> state)
+    : state(state)
+{
+}
+
+bool JobHandle::done() const
+{
+    return !state || state->finished;
+}
+
+JobSystem::JobSystem(size_t threadCount)
+    : mainThread(std::this_thread::get_id())
+{
+    if (threadCount == 0) {
+        size_t hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    for (size_t i = 0; i <= threadCount; i++) {
+        queues.emplace_back(new Queue());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleep.notify_all();
+
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+}
+
+JobHandle JobSystem::run(Task task, JobAffinity affinity)
+{
+    return after({}, std::move(task), affinity);
+}
+
+JobHandle JobSystem::after(const std::vector<JobHandle>& dependencies, Task task, JobAffinity affinity)
+{
+    auto job = std::make_shared<JobState>();
+    job->task = std::move(task);
+    job->affinity = affinity;
+
+    for (auto&& dependency : dependencies) {
+        if (!dependency.state) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(dependency.state->mutex);
+        if (!dependency.state->finished) {
+            ++job->blockers;
+            dependency.state->continuations.push_back(job);
+        }
+    }
+
+    // wired up, dependencies might have finished in the meantime
+    if (--job->blockers == 0) {
+        schedule(job);
+    }
+
+    return JobHandle(job);
+}
+
+JobHandle JobSystem::then(const JobHandle& dependency, Task task, JobAffinity affinity)
+{
+    return after({ dependency }, std::move(task), affinity);
+}
+
+void JobSystem::wait(const JobHandle& handle)
+{
+    while (!handle.done()) {
+        if (auto job = findJob(); job) {
+            execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::wait(const std::vector<JobHandle>& handles)
+{
+    for (auto&& handle : handles) {
+        wait(handle);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // not worth waking anyone up
+    if (count == 1 || threads.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    // one runner per thread, each pulls items until there are none left
+    std::atomic<size_t> next { 0 };
+    auto runner = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            job(i);
+        }
+    };
+
+    // the runners reference our stack, so they all have to be gone before we return. even when job throws here
+    std::vector<JobHandle> runners;
+    std::exception_ptr error;
+    try {
+        size_t runnerCount = std::min(count, concurrency()) - 1;
+        for (size_t i = 0; i < runnerCount; i++) {
+            runners.push_back(run(runner));
+        }
+        runner();
+    } catch (...) {
+        error = std::current_exception();
+        // the others dont need to start on anything new
+        next = count;
+    }
+    wait(runners);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+size_t JobSystem::concurrency() const
+{
+    return threads.size() + 1;
+}
+
+bool JobSystem::isMainThread() const
+{
+    return std::this_thread::get_id() == mainThread;
+}
+
+void JobSystem::workerLoop(size_t queueIndex)
+{
+    currentQueue = queueIndex;
+    for (;;) {
+        if (auto job = findJob(); job) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleep.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::schedule(const JobPtr& job)
+{
+    if (job->affinity == JobAffinity::Main) {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        mainQueue.jobs.push_back(job);
+        return;
+    }
+
+    auto& queue = *queues[std::min(currentQueue, queues.size() - 1)];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+
+    ++queued;
+    // take the lock, so a worker cant miss this between checking and going to sleep
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleep.notify_one();
+}
+
+void JobSystem::execute(const JobPtr& job)
+{
+    try {
+        job->task();
+    } catch (std::exception& e) {
+        SDL_Log("Error in job %s", e.what());
+    } catch (...) {
+        // anything else would take the whole worker thread down
+        SDL_Log("Error in job, not a std::exception");
+    }
+    job->task = nullptr;
+
+    std::vector<JobPtr> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished = true;
+        continuations.swap(job->continuations);
+    }
+
+    for (auto&& continuation : continuations) {
+        if (--continuation->blockers == 0) {
+            schedule(continuation);
+        }
+    }
+}
+
+JobSystem::JobPtr JobSystem::findJob()
+{
+    if (isMainThread()) {
+        if (auto job = popMain(); job) {
+            return job;
+        }
+    }
+
+    size_t own = std::min(currentQueue, queues.size() - 1);
+    // own queue from the back, everyone else from the front
+    for (size_t i = 0; i < queues.size(); i++) {
+        auto& queue = *queues[(own + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+
+        JobPtr job;
+        if (i == 0) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        --queued;
+        return job;
+    }
+
+    return nullptr;
+}
+
+JobSystem::JobPtr JobSystem::popMain()
+{
+    std::lock_guard<std::mutex> lock(mainQueue.mutex);
+    if (mainQueue.jobs.empty()) {
+        return nullptr;
+    }
+
+    auto job = std::move(mainQueue.jobs.front());
+    mainQueue.jobs.pop_front();
+    return job;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+    jobs.h: work stealing job system
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _runtime_jobs_h
+#define _runtime_jobs_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobState;
+
+// Handle to a job. Cheap to copy, an empty handle counts as done.
+class JobHandle {
+public:
+    JobHandle() = default;
+    bool done() const;
+
+private:
+    friend class JobSystem;
+    explicit JobHandle(std::shared_ptr<JobState> state);
+    std::shared_ptr<JobState> state;
+};
+
+enum class JobAffinity {
+    Any, // whoever is free
+    Main // python, sdl and everything else that must not leave the main thread
+};
+
+// Every thread has its own job deque. Threads take new work from the back of their own deque
+// and steal from the front of the others when theirs runs dry.
+// Main-affine jobs go to a separate queue that only the main thread (the one that made the JobSystem) drains.
+// Waiting on a job never just blocks, the waiting thread runs other jobs meanwhile.
+class JobSystem {
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads -> one less than the hardware has, the main thread works too
+    explicit JobSystem(size_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // fork
+    JobHandle run(Task task, JobAffinity affinity = JobAffinity::Any);
+    // continuation: runs once everything in dependencies is done
+    JobHandle after(const std::vector<JobHandle>& dependencies, Task task, JobAffinity affinity = JobAffinity::Any);
+    JobHandle then(const JobHandle& dependency, Task task, JobAffinity affinity = JobAffinity::Any);
+
+    // join. runs other jobs while waiting
+    void wait(const JobHandle& handle);
+    void wait(const std::vector<JobHandle>& handles);
+
+    // calls job(i) for every i in [0, count) and returns when all of them are done
+    void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+    // workers plus the main thread
+    size_t concurrency() const;
+    bool isMainThread() const;
+
+    static std::shared_ptr<JobSystem> instance;
+
+private:
+    using JobPtr = std::shared_ptr<JobState>;
+    struct Queue {
+        std::mutex mutex;
+        std::deque<JobPtr> jobs;
+    };
+
+    void workerLoop(size_t queueIndex);
+    void schedule(const JobPtr& job);
+    void execute(const JobPtr& job);
+    JobPtr findJob();
+    JobPtr popMain();
+
+    std::thread::id mainThread;
+    std::vector<std::thread> threads;
+    // one per worker, the last one belongs to the main thread and everything else that is not a worker
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue mainQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleep;
+    std::atomic<size_t> queued { 0 };
+    bool stopping = false;
+};
+
+#endif // _runtime_jobs_h
\ No newline at end of file
@@ -20,7 +20,10 @@
 #include <GL/glcorearb.h>
 
 #include "tinyxml2.h"
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 // clang-format off
 #include "imgui.h"
 #include "examples/imgui_impl_opengl3.h"
@@ -31,14 +34,97 @@
 #include "python/python.h"
 #include "editors/overlay.h"
 #include "runtime/filename.h"
+#include "runtime/framepacer.h"
+#include "runtime/profiler.h"
 #include "runtime/window.h"
 #include "systems/init.h"
+#include "systems/render.h"
+
+// window, renderer, gl and imgui. exits if any of that does not work
+static void initWindow(const std::string& appName)
+{
+    // sdl window and gles
+    const char* glsl_version = "#version 100";
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+    SDL_DisplayMode current;
+    SDL_GetCurrentDisplayMode(0, &current);
+
+    Window::window = SDL_CreateWindow(appName.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280, 720, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+    if (!Window::window) {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cannot create window", SDL_GetError(), nullptr);
+        std::cerr << "Cannot create window" << SDL_GetError() << std::endl;
+        exit(3);
+    }
+
+    Window::renderer = SDL_CreateRenderer(Window::window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+    if (!Window::renderer) {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cannot create renderer", SDL_GetError(), Window::window);
+        std::cerr << "Cannot create renderer" << SDL_GetError() << std::endl;
+        exit(3);
+    }
+    SDL_RenderClear(Window::renderer); // makes renderer active
+
+    // gl3w
+    auto gl3wres = gl3wInit();
+    bool err = gl3wres != 0;
+    if (err) {
+        std::cerr << "Failed to init gl3w:" << gl3wres << std::endl;
+        if (gl3wres == GL3W_ERROR_OPENGL_VERSION) {
+            std::cerr << "trying to continue with broken gl3w cause its a version mismatch error that can happen with gles contexts" << std::endl
+                      << "this might crash" << std::endl;
+        } else {
+            exit(3);
+        }
+    }
+
+    // imgui setup
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    // we are supposed to give a context here, but what for?
+    ImGui_ImplSDL2_InitForOpenGL(Window::window, nullptr);
+    ImGui_ImplOpenGL3_Init(glsl_version);
+    ImGui::StyleColorsDark();
+}
 
 int main(int argc, char* argv[])
 {
 #ifdef _DEBUG
     SDL_LogSetAllPriority(SDL_LOG_PRIORITY_INFO);
 #endif
+    // --options can go anywhere, the rest is game path and app name
+    bool headless = false;
+    bool glSprites = false;
+    int frameCount = 0;
+    double fixedDeltaTime = 1.0 / 60.0;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--gl-sprites") {
+            glSprites = true;
+        } else if (arg.compare(0, 9, "--frames=") == 0) {
+            frameCount = std::atoi(arg.c_str() + 9);
+        } else if (arg.compare(0, 5, "--dt=") == 0) {
+            fixedDeltaTime = std::atof(arg.c_str() + 5);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    // no display, no gpu. sdl still wants a video driver for events and such
+    Window::headless = headless;
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
+
     int rc = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_VIDEO);
     if (rc < 0) {
         std::cerr << "Cannot Init SDL! " << SDL_GetError() << std::endl;
@@ -60,15 +146,15 @@ int main(int argc, char* argv[])
     Filename::basePath = std::string(basePath);
     SDL_free(basePath);
 
-    if (argc >= 2) {
-        Filename::gamePath = argv[1];
+    if (args.size() >= 1) {
+        Filename::gamePath = args[0];
     } else {
         Filename::gamePath = Filename::basePath + "/" + "../";
     }
 
     std::string appName = "d2d";
-    if (argc >= 3) {
-        appName = argv[2];
+    if (args.size() >= 2) {
+        appName = args[1];
     }
     char* prefPath = SDL_GetPrefPath("dragon2d", appName.c_str());
 
@@ -81,57 +167,10 @@ int main(int argc, char* argv[])
 
     // we are runnable. put in own scope so we run some destructors of stack objects before everything explodes
     {
-        // sdl window and gles
-        const char* glsl_version = "#version 100";
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-        SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
-        SDL_DisplayMode current;
-        SDL_GetCurrentDisplayMode(0, &current);
-
-        Window::window = SDL_CreateWindow(appName.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280, 720, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
-        if (!Window::window) {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cannot create window", SDL_GetError(), nullptr);
-            std::cerr << "Cannot create window" << SDL_GetError() << std::endl;
-            exit(3);
-        }
-
-        Window::renderer = SDL_CreateRenderer(Window::window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
-        if (!Window::renderer) {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cannot create renderer", SDL_GetError(), Window::window);
-            std::cerr << "Cannot create renderer" << SDL_GetError() << std::endl;
-            exit(3);
-        }
-        SDL_RenderClear(Window::renderer); // makes renderer active
-
-        // gl3w
-        auto gl3wres = gl3wInit();
-        bool err = gl3wres != 0;
-        if (err) {
-            std::cerr << "Failed to init gl3w:" << gl3wres << std::endl;
-            if (gl3wres == GL3W_ERROR_OPENGL_VERSION) {
-                std::cerr << "trying to continue with broken gl3w cause its a version mismatch error that can happen with gles contexts" << std::endl
-                          << "this might crash" << std::endl;
-            } else {
-                exit(3);
-            }
+        if (!headless) {
+            initWindow(appName);
         }
 
-        // imgui setup
-        // Setup Dear ImGui context
-        IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
-        ImGuiIO& io = ImGui::GetIO();
-        // we are supposed to give a context here, but what for?
-        ImGui_ImplSDL2_InitForOpenGL(Window::window, nullptr);
-        ImGui_ImplOpenGL3_Init(glsl_version);
-        (void)io;
-        ImGui::StyleColorsDark();
-
         
 
         // we want the interpreter to exit before we deinit the systems
@@ -139,6 +178,11 @@ int main(int argc, char* argv[])
         initSystems();
         pybind11::initialize_interpreter();
 
+        // falls back to SDL on its own if it cant work
+        if (glSprites && !headless) {
+            RenderSystem::instance->setGLBackend(true);
+        }
+
 
         // into the main loop
         bool running = true;
@@ -157,16 +201,28 @@ int main(int argc, char* argv[])
         // debugging/editor overlay
         Overlay overlay;
 
-        uint64_t now = SDL_GetPerformanceCounter();
-        uint64_t last = now;
+        // headless runs as fast as it can with a fixed dt, so runs are repeatable
+        FramePacer pacer(headless ? 0.0 : 120.0);
+        if (headless) {
+            deltaTime = fixedDeltaTime;
+        }
+        int frame = 0;
+        uint64_t runStart = SDL_GetPerformanceCounter();
         while (running) {
+            Profiler::beginFrame();
+
             // poll events
             SDL_Event e;
-            while (SDL_PollEvent(&e)) {
-                ImGui_ImplSDL2_ProcessEvent(&e);
-                processEvent(e);
-                if (e.type == SDL_QUIT) {
-                    running = false;
+            {
+                PROFILE_SCOPE("Events");
+                while (SDL_PollEvent(&e)) {
+                    if (!headless) {
+                        ImGui_ImplSDL2_ProcessEvent(&e);
+                    }
+                    processEvent(e);
+                    if (e.type == SDL_QUIT) {
+                        running = false;
+                    }
                 }
             }
 
@@ -174,6 +230,22 @@ int main(int argc, char* argv[])
                 break;
             }
 
+            if (frameCount > 0 && frame >= frameCount) {
+                break;
+            }
+            frame++;
+
+            if (headless) {
+                {
+                    PROFILE_SCOPE("Systems");
+                    updateSystems(deltaTime);
+                }
+                // the pacer only keeps the stats here
+                pacer.endFrame();
+                Profiler::endFrame();
+                continue;
+            }
+
             // clear screen
             SDL_SetRenderDrawColor(Window::renderer, 0, 0, 0, 255);
             SDL_RenderClear(Window::renderer);
@@ -184,26 +256,51 @@ int main(int argc, char* argv[])
             ImGui::NewFrame();
 
             // now do the system updates
-            overlay.update(deltaTime);
-            updateSystems(deltaTime);
+            {
+                PROFILE_SCOPE("Overlay");
+                overlay.update(deltaTime);
+            }
+            {
+                PROFILE_SCOPE("Systems");
+                updateSystems(deltaTime);
+            }
 
             // this flushes the renderer. after this only imgui
-            SDL_RenderFlush(Window::renderer);
+            {
+                PROFILE_SCOPE("Render flush");
+                SDL_RenderFlush(Window::renderer);
+            }
 
             // now render imgui
-            ImGui::Render(); // thos does not actually render (as in: draw calls)
-            glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // this does, though
+            {
+                PROFILE_SCOPE("ImGui render");
+                ImGui::Render(); // thos does not actually render (as in: draw calls)
+                ImGuiIO& io = ImGui::GetIO();
+                glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // this does, though
+            }
             // and swap
-            SDL_GL_SwapWindow(Window::window);
-
+            {
+                PROFILE_SCOPE("Swap");
+                SDL_GL_SwapWindow(Window::window);
+            }
 
-            deltaTime = (double)((now - last) / (double)SDL_GetPerformanceFrequency());
-            last = now;
-            now = SDL_GetPerformanceCounter();
-            if (deltaTime < 0.008) {
-                SDL_Delay(static_cast<int>((0.008 - deltaTime) * 1000));
+            // wait for the frame deadline. the time of this frame is the dt for the next one
+            {
+                PROFILE_SCOPE("Frame pacing");
+                deltaTime = pacer.endFrame();
             }
+            Profiler::endFrame();
+        }
+
+        if (headless) {
+            double seconds = static_cast<double>(SDL_GetPerformanceCounter() - runStart) / static_cast<double>(SDL_GetPerformanceFrequency());
+            SDL_Log("Headless: %d frames in %.3f s, %.3f ms per frame (worst of the last %d: %.3f ms)",
+                frame,
+                seconds,
+                frame ? seconds * 1000.0 / frame : 0.0,
+                static_cast<int>(FramePacer::historySize),
+                pacer.getMaxFrameTime() * 1000.0);
         }
 
         // cleanup 
@@ -212,8 +309,10 @@ int main(int argc, char* argv[])
         pybind11::finalize_interpreter();
         finishSystems();
 
-        SDL_DestroyRenderer(Window::renderer);
-        SDL_DestroyWindow(Window::window);
+        if (!headless) {
+            SDL_DestroyRenderer(Window::renderer);
+            SDL_DestroyWindow(Window::window);
+        }
     }
     SDL_Quit();
 
@@ -0,0 +1,277 @@
+/*
+    profiler.cpp: scoped timers and per-frame timing history
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "profiler.h"
+
+#include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+// what one thread recorded in the current frame. the lock is only ever contended by endFrame
+struct ThreadEvents {
+    std::mutex mutex;
+    std::vector<ProfileEvent> events;
+};
+
+struct ProfilerData {
+    std::array<ProfileFrame, Profiler::historySize> frames;
+    // where the frame that is recorded right now goes
+    size_t current = 0;
+    size_t count = 0;
+    std::atomic<bool> inFrame { false };
+    std::vector<Profiler::Zone> zones;
+
+    // zone names by id. a deque, so the strings never move
+    std::mutex namesMutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIds;
+
+    // one per thread that ever recorded, they stay around after the thread is gone
+    std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadEvents>> threads;
+};
+
+ProfilerData& data()
+{
+    static ProfilerData profilerData;
+    return profilerData;
+}
+
+std::atomic<bool> enabled(true);
+std::atomic<uint32_t> nextThreadIndex(0);
+thread_local uint32_t scopeDepth = 0;
+
+ThreadEvents& threadEvents()
+{
+    thread_local ThreadEvents* events = nullptr;
+    if (!events) {
+        auto& d = data();
+        std::lock_guard<std::mutex> lock(d.threadsMutex);
+        d.threads.emplace_back(new ThreadEvents());
+        events = d.threads.back().get();
+    }
+    return *events;
+}
+}
+
+void Profiler::beginFrame()
+{
+    if (!enabled) {
+        return;
+    }
+
+    auto& d = data();
+    auto& frame = d.frames[d.current];
+    // keeps the memory of whatever frame was here before
+    frame.events.clear();
+    // whatever came in between frames does not count
+    std::lock_guard<std::mutex> threadsLock(d.threadsMutex);
+    for (auto&& thread : d.threads) {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        thread->events.clear();
+    }
+    frame.start = SDL_GetPerformanceCounter();
+    frame.end = frame.start;
+    d.inFrame = true;
+}
+
+void Profiler::endFrame()
+{
+    auto& d = data();
+    if (!d.inFrame) {
+        return;
+    }
+
+    auto& frame = d.frames[d.current];
+    frame.end = SDL_GetPerformanceCounter();
+    d.inFrame = false;
+
+    // all threads into the frame. the vectors keep their memory, so this does not allocate once warm
+    {
+        std::lock_guard<std::mutex> threadsLock(d.threadsMutex);
+        for (auto&& thread : d.threads) {
+            std::lock_guard<std::mutex> lock(thread->mutex);
+            frame.events.insert(frame.events.end(), thread->events.begin(), thread->events.end());
+            thread->events.clear();
+        }
+    }
+
+    // zones that got a name since the last frame
+    {
+        std::lock_guard<std::mutex> lock(d.namesMutex);
+        while (d.zones.size() < d.names.size()) {
+            d.zones.emplace_back();
+            d.zones.back().name = d.names[d.zones.size() - 1];
+        }
+    }
+
+    for (auto&& zone : d.zones) {
+        zone.milliseconds[d.current] = 0.0f;
+    }
+    for (auto&& event : frame.events) {
+        d.zones[event.zone].milliseconds[d.current] += static_cast<float>(toMilliseconds(event.end - event.start));
+    }
+
+    d.current = (d.current + 1) % historySize;
+    d.count = std::min(d.count + 1, historySize);
+}
+
+uint32_t Profiler::zoneId(const char* name)
+{
+    auto& d = data();
+    std::lock_guard<std::mutex> lock(d.namesMutex);
+    auto iter = d.nameIds.find(name);
+    if (iter != d.nameIds.end()) {
+        return iter->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(d.names.size());
+    d.names.emplace_back(name);
+    d.nameIds[name] = id;
+    return id;
+}
+
+void Profiler::record(uint32_t zone, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+{
+    if (!data().inFrame) {
+        return;
+    }
+
+    ProfileEvent event;
+    event.name = name;
+    event.zone = zone;
+    event.start = start;
+    event.end = end;
+    event.thread = threadIndex();
+    event.depth = depth;
+
+    auto& events = threadEvents();
+    std::lock_guard<std::mutex> lock(events.mutex);
+    events.events.push_back(event);
+}
+
+void Profiler::setEnabled(bool newEnabled)
+{
+    enabled = newEnabled;
+}
+
+bool Profiler::isEnabled()
+{
+    return enabled;
+}
+
+size_t Profiler::frameCount()
+{
+    return data().count;
+}
+
+size_t Profiler::historyPosition(size_t i)
+{
+    auto& d = data();
+    return (d.current + historySize - d.count + i) % historySize;
+}
+
+const ProfileFrame& Profiler::frame(size_t i)
+{
+    return data().frames[historyPosition(i)];
+}
+
+const std::vector<Profiler::Zone>& Profiler::getZones()
+{
+    return data().zones;
+}
+
+double Profiler::toMilliseconds(uint64_t ticks)
+{
+    static const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    return static_cast<double>(ticks) * 1000.0 / frequency;
+}
+
+uint32_t Profiler::threadIndex()
+{
+    thread_local uint32_t index = nextThreadIndex++;
+    return index;
+}
+
+static std::string jsonEscape(const char* str)
+{
+    std::string result;
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            result += '\\';
+        }
+        result += *str;
+    }
+    return result;
+}
+
+bool Profiler::exportChromeTrace(const std::string& filename)
+{
+    std::ofstream file(filename);
+    if (!file) {
+        SDL_Log("Cannot write profile to %s", filename.c_str());
+        return false;
+    }
+
+    size_t count = frameCount();
+    uint64_t origin = count ? frame(0).start : 0;
+    auto micros = [origin](uint64_t ticks) {
+        return toMilliseconds(ticks - origin) * 1000.0;
+    };
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        const auto& f = frame(i);
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":0,\"tid\":\"frames\",\"ts\":" << micros(f.start)
+             << ",\"dur\":" << micros(f.end) - micros(f.start) << "}";
+        first = false;
+        for (auto&& event : f.events) {
+            file << ",\n{\"name\":\"" << jsonEscape(event.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+                 << ",\"ts\":" << micros(event.start) << ",\"dur\":" << micros(event.end) - micros(event.start) << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    SDL_Log("Wrote %zu frames of profile to %s", count, filename.c_str());
+    return true;
+}
+
+ProfileScope::ProfileScope(uint32_t zone, const char* name)
+    : zone(zone)
+    , name(name)
+    , start(0)
+    , active(enabled)
+{
+    if (active) {
+        scopeDepth++;
+        start = SDL_GetPerformanceCounter();
+    }
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (active) {
+        uint64_t end = SDL_GetPerformanceCounter();
+        scopeDepth--;
+        Profiler::record(zone, name, start, end, scopeDepth);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+    profiler.h: scoped timers and per-frame timing history
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _runtime_profiler_h
+#define _runtime_profiler_h
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// one timed scope
+struct ProfileEvent {
+    // has to outlive the history: string literals, or names owned by something that stays around
+    const char* name;
+    uint32_t zone;
+    uint64_t start;
+    uint64_t end;
+    uint32_t thread;
+    uint32_t depth;
+};
+
+struct ProfileFrame {
+    uint64_t start = 0;
+    uint64_t end = 0;
+    std::vector<ProfileEvent> events;
+};
+
+// Collects scoped timings from all threads, one frame at a time.
+// The last historySize frames are kept as raw events (timeline, chrome trace)
+// and as milliseconds per zone and frame (graphs). Zones are scopes with the same name,
+// numbered once per name so recording never looks up strings.
+// Every thread records into a buffer of its own, endFrame collects them. Reading the history
+// is for the main thread, only endFrame changes it.
+class Profiler {
+public:
+    static constexpr size_t historySize = 120;
+
+    struct Zone {
+        std::string name;
+        // ring buffer, same positions as the frames. see historyPosition
+        std::array<float, historySize> milliseconds = {};
+    };
+
+    static void beginFrame();
+    static void endFrame();
+    // the id of a zone name, new names get the next one. takes a lock, so once per name and not per scope
+    static uint32_t zoneId(const char* name);
+    // ProfileScope calls this
+    static void record(uint32_t zone, const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+    // off: scopes cost a branch and nothing gets recorded. on by default
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // finished frames in the history, and the ring position of the ith one (0 = oldest)
+    static size_t frameCount();
+    static size_t historyPosition(size_t i);
+    static const ProfileFrame& frame(size_t i);
+    // by zone id
+    static const std::vector<Zone>& getZones();
+
+    static double toMilliseconds(uint64_t ticks);
+    // small number per thread, main thread is whoever records first (so: 0)
+    static uint32_t threadIndex();
+
+    // every frame in the history as complete events, for chrome://tracing or perfetto
+    static bool exportChromeTrace(const std::string& filename);
+};
+
+class ProfileScope {
+public:
+    // name has to live as long as the history, zone is its zoneId
+    ProfileScope(uint32_t zone, const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    uint32_t zone;
+    const char* name;
+    uint64_t start;
+    bool active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times everything until the end of the enclosing scope. The zone id is looked up once per call site,
+// so name has to be the same every time. For names that change use ProfileScope with your own zoneId
+#define PROFILE_SCOPE(name)                                                               \
+    static const uint32_t PROFILE_CONCAT(profileZone, __LINE__) = Profiler::zoneId(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZone, __LINE__), name)
+
+#endif // _runtime_profiler_h
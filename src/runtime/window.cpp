@@ -15,4 +15,5 @@
 #include "window.h"
 
 SDL_Window* Window::window = nullptr;
-SDL_Renderer* Window::renderer = nullptr;
\ No newline at end of file
+SDL_Renderer* Window::renderer = nullptr;
+bool Window::headless = false;
\ No newline at end of file
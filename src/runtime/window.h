@@ -22,6 +22,8 @@ class Window
 public:
     static SDL_Window* window;
     static SDL_Renderer* renderer;
+    // --headless: no window, no renderer, no imgui
+    static bool headless;
 };
 
 #endif //_runtime_window_h
\ No newline at end of file
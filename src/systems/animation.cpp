@@ -16,6 +16,7 @@
 #include "animation.h"
 
 #include "SDL.h"
+#include "runtime/jobs.h"
 #include "tinyxml2.h"
 #include "util/xmlhelpers.h"
 namespace xml = tinyxml2;
@@ -169,20 +170,26 @@ void AnimationSystem::remove(const IndexType& i)
     animations.remove(i);
 }
 
+void AnimationSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    animations.removeMany(indices);
+}
+
 void AnimationSystem::update(double dt)
 {
-    for (auto&& animation : animations) {
+    // every animation only touches its own sprite, so this can go wide
+    animations.parallelForEach(*JobSystem::instance, [dt](AnimatedSprite& animation) {
         if (animation.current >= animation.animations.size()) {
-            continue;
+            return;
         }
 
         auto& current = animation.animations[animation.current];
         if (!current.playing) {
-            continue;
+            return;
         }
 
         if (current.currentFrame >= current.frames.size()) {
-            continue;
+            return;
         }
 
         current.frameTime += dt;
@@ -196,7 +203,7 @@ void AnimationSystem::update(double dt)
                 if (!current.loop) {
                     // stop playing and iterate on
                     current.playing = false;
-                    continue;
+                    return;
                 }
             }
         }
@@ -204,5 +211,5 @@ void AnimationSystem::update(double dt)
         // update the sprite
         auto& sprite = RenderSystem::instance->getSprite(animation.spriteId);
         sprite.source = current.frames[current.currentFrame].src;
-    }
+    });
 }
@@ -16,7 +16,9 @@
 #define _systems_animation_h
 
 #include "systems/component.h"
+#include "systems/schedule.h"
 #include "systems/rendercomponents.h"
+#include "util/denseslotmap.h"
 #include "util/rect.h"
 
 struct Frame {
@@ -56,13 +58,15 @@ public:
     IndexType create(const SpriteComponent& sprite, const std::string& filename);
     AnimatedSprite& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
 
+    static constexpr SystemAccess access = { StoreAnimation, StoreAnimation | StoreSprite, false };
     void update(double dt);
 
     static std::shared_ptr<AnimationSystem> instance;
 
 private:
-    SlotMap<AnimatedSprite> animations;
+    DenseSlotMap<AnimatedSprite> animations;
 };
 
 #endif // _systems_animation_h
\ No newline at end of file
@@ -0,0 +1,305 @@
+/*
+    archetype.cpp: entities grouped by their component set
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "archetype.h"
+
+#include "SDL.h"
+#include <algorithm>
+#include <array>
+
+ArchetypeStore::ArchetypeStore()
+{
+    // the empty one is always 0
+    findOrCreateArchetype(Signature());
+}
+
+ArchetypeStore::~ArchetypeStore()
+{
+    // removing components can drop python entities, which can land back in here. so: rounds until empty
+    std::vector<EntityId> entities;
+    while (records.begin() != records.end()) {
+        entities.clear();
+        for (auto iter = records.begin(); iter != records.end(); ++iter) {
+            entities.push_back(iter.getGenerationIndex());
+        }
+        destroy(entities);
+    }
+}
+
+EntityId ArchetypeStore::create()
+{
+    return create(Signature(), nullptr);
+}
+
+EntityId ArchetypeStore::create(const Signature& signature, const uint64_t* components)
+{
+    uint32_t archetypeIndex = findOrCreateArchetype(signature);
+    auto& archetype = archetypes[archetypeIndex];
+
+    Record record;
+    record.archetype = archetypeIndex;
+    record.row = static_cast<uint32_t>(archetype.entities.size());
+    EntityId entity = records.insert(record);
+
+    for (size_t i = 0; i < archetype.columns.size(); i++) {
+        archetype.columns[i].push_back(components[i]);
+        setOwner(archetype.signature[i], components[i], entity);
+    }
+    archetype.entities.push_back(entity);
+
+    return entity;
+}
+
+void ArchetypeStore::reserve(const Signature& signature, size_t count)
+{
+    auto& archetype = archetypes[findOrCreateArchetype(signature)];
+    for (auto&& column : archetype.columns) {
+        column.reserve(column.size() + count);
+    }
+    archetype.entities.reserve(archetype.entities.size() + count);
+}
+
+void ArchetypeStore::addComponent(const EntityId& entity, ComponentTypeId type, uint64_t rawIndex)
+{
+    auto recordIter = records.find(entity);
+    if (recordIter == records.end()) {
+        SDL_Log("Adding a component to an entity that does not exist anymore");
+        removeComponent(type, rawIndex);
+        return;
+    }
+
+    uint32_t fromIndex = recordIter->archetype;
+    uint32_t row = recordIter->row;
+
+    uint32_t toIndex;
+    if (auto edge = archetypes[fromIndex].addEdges.find(type); edge != archetypes[fromIndex].addEdges.end()) {
+        toIndex = edge->second;
+    } else {
+        Signature signature = archetypes[fromIndex].signature;
+        signature.insert(std::upper_bound(signature.begin(), signature.end(), type), type);
+        // can add archetypes, so no references into archetypes before this
+        toIndex = findOrCreateArchetype(signature);
+        archetypes[fromIndex].addEdges[type] = toIndex;
+    }
+
+    auto& from = archetypes[fromIndex];
+    auto& to = archetypes[toIndex];
+    size_t newColumn = std::upper_bound(from.signature.begin(), from.signature.end(), type) - from.signature.begin();
+    for (size_t i = 0; i < to.columns.size(); i++) {
+        if (i < newColumn) {
+            to.columns[i].push_back(from.columns[i][row]);
+        } else if (i == newColumn) {
+            to.columns[i].push_back(rawIndex);
+        } else {
+            to.columns[i].push_back(from.columns[i - 1][row]);
+        }
+    }
+    to.entities.push_back(entity);
+
+    removeRow(fromIndex, row);
+    recordIter->archetype = toIndex;
+    recordIter->row = static_cast<uint32_t>(to.entities.size() - 1);
+    setOwner(type, rawIndex, entity);
+}
+
+void ArchetypeStore::destroy(const EntityId& entity)
+{
+    auto recordIter = records.find(entity);
+    if (recordIter == records.end()) {
+        return;
+    }
+
+    uint32_t archetypeIndex = recordIter->archetype;
+    uint32_t row = recordIter->row;
+
+    // Take the components out first, and only then remove them.
+    // Removing one can drop the last reference to some python entity, which lands right back in here.
+    using Component = std::pair<ComponentTypeId, uint64_t>;
+    std::array<Component, 16> local;
+    std::vector<Component> overflow;
+    const auto& archetype = archetypes[archetypeIndex];
+    size_t count = archetype.columns.size();
+    Component* components = local.data();
+    if (count > local.size()) {
+        overflow.resize(count);
+        components = overflow.data();
+    }
+    for (size_t i = 0; i < count; i++) {
+        components[i] = std::make_pair(archetype.signature[i], archetype.columns[i][row]);
+        clearOwner(components[i].first, components[i].second);
+    }
+
+    removeRow(archetypeIndex, row);
+    records.remove(entity);
+
+    for (size_t i = 0; i < count; i++) {
+        removeComponent(components[i].first, components[i].second);
+    }
+}
+
+void ArchetypeStore::destroy(const std::vector<EntityId>& entities)
+{
+    // same as above: take everything out, then remove. swapped out in case we land back in here
+    std::vector<ComponentEntry> components;
+    components.swap(teardown);
+
+    for (auto&& entity : entities) {
+        auto recordIter = records.find(entity);
+        if (recordIter == records.end()) {
+            continue;
+        }
+
+        uint32_t archetypeIndex = recordIter->archetype;
+        uint32_t row = recordIter->row;
+        const auto& archetype = archetypes[archetypeIndex];
+        for (size_t i = 0; i < archetype.columns.size(); i++) {
+            components.push_back(std::make_pair(archetype.signature[i], archetype.columns[i][row]));
+            clearOwner(archetype.signature[i], archetype.columns[i][row]);
+        }
+
+        removeRow(archetypeIndex, row);
+        records.remove(entity);
+    }
+
+    // grouped by type, and in slot order within the type (the low half of the raw index)
+    std::sort(components.begin(), components.end(), [](const ComponentEntry& a, const ComponentEntry& b) {
+        return std::make_pair(a.first, static_cast<uint32_t>(a.second)) < std::make_pair(b.first, static_cast<uint32_t>(b.second));
+    });
+
+    // one removeMany per type
+    std::vector<uint64_t> rawIndices;
+    rawIndices.swap(teardownIndices);
+    for (size_t first = 0; first < components.size();) {
+        ComponentTypeId type = components[first].first;
+        rawIndices.clear();
+        size_t last = first;
+        for (; last < components.size() && components[last].first == type; last++) {
+            rawIndices.push_back(components[last].second);
+        }
+        removeComponents(type, rawIndices.data(), rawIndices.size());
+        first = last;
+    }
+    rawIndices.clear();
+    teardownIndices.swap(rawIndices);
+
+    components.clear();
+    teardown.swap(components);
+}
+
+bool ArchetypeStore::valid(const EntityId& entity) const
+{
+    return records.find(entity) != records.end();
+}
+
+bool ArchetypeStore::findComponent(const EntityId& entity, ComponentTypeId type, uint64_t& rawIndex, size_t nth) const
+{
+    auto recordIter = records.find(entity);
+    if (recordIter == records.end()) {
+        return false;
+    }
+
+    const auto& archetype = archetypes[recordIter->archetype];
+    auto range = std::equal_range(archetype.signature.begin(), archetype.signature.end(), type);
+    if (nth >= static_cast<size_t>(range.second - range.first)) {
+        return false;
+    }
+
+    size_t column = (range.first - archetype.signature.begin()) + nth;
+    rawIndex = archetype.columns[column][recordIter->row];
+    return true;
+}
+
+bool ArchetypeStore::ownerOf(ComponentTypeId type, uint64_t rawIndex, EntityId& entity) const
+{
+    uint32_t slot = static_cast<uint32_t>(rawIndex);
+    if (type >= owners.size() || slot >= owners[type].size()) {
+        return false;
+    }
+
+    // the full raw index has to match, so stale handles find nothing
+    const auto& owner = owners[type][slot];
+    if (owner.rawIndex != rawIndex) {
+        return false;
+    }
+
+    entity = owner.entity;
+    return true;
+}
+
+size_t ArchetypeStore::archetypeCount() const
+{
+    return archetypes.size();
+}
+
+const Archetype& ArchetypeStore::archetype(size_t i) const
+{
+    return archetypes[i];
+}
+
+uint32_t ArchetypeStore::findOrCreateArchetype(const Signature& signature)
+{
+    if (auto iter = lookup.find(signature); iter != lookup.end()) {
+        return iter->second;
+    }
+
+    Archetype archetype;
+    archetype.signature = signature;
+    archetype.columns.resize(signature.size());
+    archetypes.push_back(std::move(archetype));
+
+    uint32_t index = static_cast<uint32_t>(archetypes.size() - 1);
+    lookup[signature] = index;
+    return index;
+}
+
+void ArchetypeStore::setOwner(ComponentTypeId type, uint64_t rawIndex, const EntityId& entity)
+{
+    uint32_t slot = static_cast<uint32_t>(rawIndex);
+    if (type >= owners.size()) {
+        owners.resize(type + 1);
+    }
+    auto& typeOwners = owners[type];
+    if (slot >= typeOwners.size()) {
+        typeOwners.resize(slot + 1);
+    }
+
+    typeOwners[slot].rawIndex = rawIndex;
+    typeOwners[slot].entity = entity;
+}
+
+void ArchetypeStore::clearOwner(ComponentTypeId type, uint64_t rawIndex)
+{
+    uint32_t slot = static_cast<uint32_t>(rawIndex);
+    if (type < owners.size() && slot < owners[type].size() && owners[type][slot].rawIndex == rawIndex) {
+        owners[type][slot] = Owner();
+    }
+}
+
+void ArchetypeStore::removeRow(uint32_t archetypeIndex, uint32_t row)
+{
+    auto& archetype = archetypes[archetypeIndex];
+    size_t last = archetype.entities.size() - 1;
+    if (row != last) {
+        for (auto&& column : archetype.columns) {
+            column[row] = column[last];
+        }
+        archetype.entities[row] = archetype.entities[last];
+        records[archetype.entities[row]].row = row;
+    }
+
+    for (auto&& column : archetype.columns) {
+        column.pop_back();
+    }
+    archetype.entities.pop_back();
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+    archetype.h: entities grouped by their component set
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_archetype_h
+#define _systems_archetype_h
+
+#include "systems/component.h"
+#include "util/slotmap.h"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+using EntityId = SlotMapIndex;
+// sorted component type ids. the same type can show up more than once (several inputs etc)
+using Signature = std::vector<ComponentTypeId>;
+
+// All entities with the same signature share one table.
+// Every signature entry is a column of raw component indices, every entity is a row.
+struct Archetype {
+    Signature signature;
+    std::vector<std::vector<uint64_t>> columns;
+    std::vector<EntityId> entities;
+    // where adding a component of some type leads to
+    std::unordered_map<ComponentTypeId, uint32_t> addEdges;
+
+    size_t size() const
+    {
+        return entities.size();
+    }
+};
+
+// The entities and the components they own.
+// Entities move between archetypes as components get added; after warming up that does not allocate anymore.
+// Destroying an entity removes all of its components from their systems.
+class ArchetypeStore {
+public:
+    ArchetypeStore();
+    ~ArchetypeStore();
+
+    ArchetypeStore(const ArchetypeStore&) = delete;
+    ArchetypeStore& operator=(const ArchetypeStore&) = delete;
+
+    // empty entity
+    EntityId create();
+    // entity with all of its components at once. components has one raw index per signature entry.
+    // the signature has to be sorted
+    EntityId create(const Signature& signature, const uint64_t* components);
+
+    // room for count more entities with that signature, so spawning a lot of them does not reallocate
+    void reserve(const Signature& signature, size_t count);
+
+    // the entity owns the component from here on
+    void addComponent(const EntityId& entity, ComponentTypeId type, uint64_t rawIndex);
+    void destroy(const EntityId& entity);
+    // many at once. the components are removed with one removeMany per type, not entity by entity
+    void destroy(const std::vector<EntityId>& entities);
+    bool valid(const EntityId& entity) const;
+
+    // raw index of the nth component of that type, false if there is none
+    bool findComponent(const EntityId& entity, ComponentTypeId type, uint64_t& rawIndex, size_t nth = 0) const;
+    // the other way around: who owns that component. false if nobody (anymore)
+    bool ownerOf(ComponentTypeId type, uint64_t rawIndex, EntityId& entity) const;
+
+    size_t archetypeCount() const;
+    const Archetype& archetype(size_t i) const;
+
+private:
+    struct Record {
+        uint32_t archetype = 0;
+        uint32_t row = 0;
+    };
+
+    uint32_t findOrCreateArchetype(const Signature& signature);
+    // swap and pop, the components stay alive
+    void removeRow(uint32_t archetypeIndex, uint32_t row);
+
+    // Reverse index, per component type a dense array by component slot (the low half of the raw index).
+    // Components dont move between slots, so this only changes when components are added or destroyed.
+    struct Owner {
+        uint64_t rawIndex = ~0ull;
+        EntityId entity = EntityId();
+    };
+    void setOwner(ComponentTypeId type, uint64_t rawIndex, const EntityId& entity);
+    void clearOwner(ComponentTypeId type, uint64_t rawIndex);
+    std::vector<std::vector<Owner>> owners;
+
+    using ComponentEntry = std::pair<ComponentTypeId, uint64_t>;
+    // kept around so batch destroys dont allocate
+    std::vector<ComponentEntry> teardown;
+    std::vector<uint64_t> teardownIndices;
+
+    std::vector<Archetype> archetypes;
+    std::map<Signature, uint32_t> lookup;
+    SlotMap<Record> records;
+};
+
+#endif // _systems_archetype_h
\ No newline at end of file
@@ -50,6 +50,11 @@ void CameraSystem::remove(const IndexType& i)
     cameras.remove(i);
 }
 
+void CameraSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    cameras.removeMany(indices);
+}
+
 const SlotMap<Camera, 32>& CameraSystem::getCameras() const
 {
     return cameras;
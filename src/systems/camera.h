@@ -38,6 +38,7 @@ public:
     IndexType create(const TransformSystem::IndexType& transformId, bool centered = true, bool fillTarget = true, const Rect& viewport = Rect());
     Camera& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
 
 	const SlotMap<Camera, 32>& getCameras() const;
 
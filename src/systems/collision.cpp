@@ -13,6 +13,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "collision.h"
+#include "view.h"
 
 class PyCollider {
 public:
@@ -25,9 +26,16 @@ public:
 };
 PyType<Collider, PyCollider, FRect> pycollider;
 
+using ColliderView = View<Transform2D, Collider>;
+
 struct CollisionGrid {
     static const int64_t maxSize = 100000000; // there be enough space
-    using CellMap = SlotMap<SlotMapIndex, 32>;
+    // the collider, and where its transform is in the view
+    struct Entry {
+        SlotMapIndex collider;
+        uint32_t row;
+    };
+    using CellMap = SlotMap<Entry, 32>;
     float cellSize = 100.0f;
 
     int64_t cell(const glm::vec2& pos)
@@ -39,10 +47,8 @@ struct CollisionGrid {
         return index;
     }
 
-    void insert(const Collider& c, const SlotMapIndex& i)
+    void insert(const FRect& actualRect, const Entry& i)
     {
-        const auto& transform = TransformSystem::instance->get(c.transformId);
-        FRect actualRect = c.aabb + transform.position;
         auto c1 = cell(actualRect.topLeft());
         auto c2 = cell(actualRect.topRight());
         auto c3 = cell(actualRect.bottomLeft());
@@ -60,10 +66,8 @@ struct CollisionGrid {
         }
     }
 
-    void allCells(std::vector<int64_t>& target, const Collider& c)
+    void allCells(std::vector<int64_t>& target, const FRect& actualRect)
     {
-        const auto& transform = TransformSystem::instance->get(c.transformId);
-        FRect actualRect = c.aabb + transform.position;
         auto c1 = cell(actualRect.topLeft());
         auto c2 = cell(actualRect.topRight());
         auto c3 = cell(actualRect.bottomLeft());
@@ -94,6 +98,7 @@ struct CollisionGrid {
 
 struct CollisionSystemData {
     SlotMap<Collider> colliders;
+    ColliderView view;
     CollisionGrid grid;
 };
 
@@ -126,7 +131,12 @@ CollisionSystem::IndexType CollisionSystem::create(const TransformSystem::IndexT
 
 Collider& CollisionSystem::get(const IndexType& i)
 {
-    return data->colliders[i];
+    // handles can outlive a destroyed entity
+    static Collider dummy;
+    if (auto iter = data->colliders.find(i); iter != data->colliders.end()) {
+        return *iter;
+    }
+    return dummy;
 }
 
 void CollisionSystem::remove(const IndexType& i)
@@ -134,12 +144,26 @@ void CollisionSystem::remove(const IndexType& i)
     data->colliders.remove(i);
 }
 
+void CollisionSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    data->colliders.removeMany(indices);
+}
+
+void CollisionSystem::shrinkToFit()
+{
+    data->colliders.shrinkToFit();
+    // rebuilt every update anyway
+    data->grid.grid.clear();
+}
+
 void CollisionSystem::update(double dt)
 {
     // TODO: maybe only update this on demand?
     data->grid.clear();
-    for (auto iter = data->colliders.begin(); iter != data->colliders.end(); ++iter) {
-        data->grid.insert(*iter, iter.getGenerationIndex());
+    data->view.build(data->colliders, TransformSystem::instance->getStorage());
+    for (size_t i = 0; i < data->view.size(); i++) {
+        const auto& row = data->view[i];
+        data->grid.insert(row.component->aabb + row.position(), { row.index, static_cast<uint32_t>(i) });
     }
 }
 
@@ -150,16 +174,21 @@ bool CollisionSystem::checkCollision(const IndexType& i)
         return false;
     }
     const auto& c = *iter;
-    const auto& transformedAabb = c.aabb + TransformSystem::instance->get(c.transformId).position;
+    const auto& transformedAabb = c.aabb + TransformSystem::instance->getPosition(c.transformId);
 
     std::vector<int64_t> cells;
-    data->grid.allCells(cells, c);
+    data->grid.allCells(cells, transformedAabb);
     for (auto&& cell : cells) {
-        for (const auto& otherIndex : data->grid.grid[cell]) {
-            if (otherIndex == i) {
+        auto cellIter = data->grid.grid.find(cell);
+        if (cellIter == data->grid.grid.end()) {
+            continue;
+        }
+        for (const auto& entry : cellIter->second) {
+            if (entry.collider == i) {
                 continue;
             }
-            auto otherIter = data->colliders.find(otherIndex);
+            // removed since the grid was built?
+            auto otherIter = data->colliders.find(entry.collider);
             if (otherIter == data->colliders.end()) {
                 continue;
             }
@@ -168,7 +197,8 @@ bool CollisionSystem::checkCollision(const IndexType& i)
             if (c.mask && other.mask && !(c.mask & other.mask)) {
                 continue;
             }
-            const auto& otherTransformedAabb = other.aabb + TransformSystem::instance->get(other.transformId).position;
+            // transform was looked up when the grid was built
+            const auto& otherTransformedAabb = other.aabb + data->view[entry.row].position();
             if (transformedAabb.intersect(otherTransformedAabb)) {
                 return true;
             }
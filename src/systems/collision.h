@@ -16,6 +16,7 @@
 #define _systems_collision_h
 
 #include "component.h"
+#include "schedule.h"
 #include "transform.h"
 #include "util/rect.h"
 
@@ -38,7 +39,11 @@ public:
     IndexType create(const TransformSystem::IndexType& transformId, const FRect& aabb, uint64_t mask = 0);
     Collider& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
+    // give back memory after a lot of removals. indices stay valid
+    void shrinkToFit();
 
+    static constexpr SystemAccess access = { StoreTransform | StoreCollider, StoreCollider, false };
     void update(double dt);
     bool checkCollision(const IndexType& i);
 
@@ -16,6 +16,39 @@
 #include "component.h"
 
 #include "python/python.h"
+#include <vector>
+
+struct ComponentType {
+    ComponentRemoveFunction remove;
+    ComponentRemoveManyFunction removeMany;
+};
+
+// function local, so registering from static init in other files is fine
+static std::vector<ComponentType>& componentTypes()
+{
+    static std::vector<ComponentType> types;
+    return types;
+}
+
+ComponentTypeId registerComponentType(ComponentRemoveFunction remove, ComponentRemoveManyFunction removeMany)
+{
+    componentTypes().push_back({ remove, removeMany });
+    return static_cast<ComponentTypeId>(componentTypes().size() - 1);
+}
+
+void removeComponent(ComponentTypeId type, uint64_t rawIndex)
+{
+    if (type < componentTypes().size()) {
+        componentTypes()[type].remove(rawIndex);
+    }
+}
+
+void removeComponents(ComponentTypeId type, const uint64_t* rawIndices, size_t count)
+{
+    if (type < componentTypes().size() && count) {
+        componentTypes()[type].removeMany(rawIndices, count);
+    }
+}
 
 class PyComponentBase
 {
@@ -18,9 +18,26 @@
 #include "python/python.h"
 #include "util/slotmap.h"
 
+// every component wrapper type gets an id, and the entity store can remove components by id and raw index
+using ComponentTypeId = uint32_t;
+using ComponentRemoveFunction = void (*)(uint64_t rawIndex);
+// count components of the same type at once, through the systems removeMany
+using ComponentRemoveManyFunction = void (*)(const uint64_t* rawIndices, size_t count);
+ComponentTypeId registerComponentType(ComponentRemoveFunction remove, ComponentRemoveManyFunction removeMany);
+void removeComponent(ComponentTypeId type, uint64_t rawIndex);
+void removeComponents(ComponentTypeId type, const uint64_t* rawIndices, size_t count);
+
 class ComponentWrapperBase {
 public:
     virtual ~ComponentWrapperBase() = default;
+
+    virtual ComponentTypeId typeId() const = 0;
+    // Hands the component over to the caller (the entity store), who has to remove it later.
+    // The wrapper keeps working as a handle, it just wont remove the component anymore.
+    // false if it was handed over before
+    virtual bool release(uint64_t& rawIndex) = 0;
+    // the index as the entity store sees it
+    virtual uint64_t getRawIndex() const = 0;
 };
 using ComponentWrapperBasePtr = std::shared_ptr<ComponentWrapperBase>;
 
@@ -37,7 +54,7 @@ public:
     ComponentWrapper(Args&&... args)
     {
         index = SystemClass::instance->create(std::forward<Args>(args)...);
-        valid = true;
+        owning = true;
     }
 
     ComponentWrapper(ComponentWrapper&& other) = delete;
@@ -46,10 +63,44 @@ public:
 
     ~ComponentWrapper()
     {
-        SystemClass::instance->remove(index);
+        if (owning) {
+            SystemClass::instance->remove(index);
+        }
+    }
+
+    static ComponentTypeId staticTypeId()
+    {
+        static const ComponentTypeId id = registerComponentType(
+            [](uint64_t rawIndex) {
+                SystemClass::instance->remove(IndexType(rawIndex));
+            },
+            [](const uint64_t* rawIndices, size_t count) {
+                SystemClass::instance->removeMany(std::vector<IndexType>(rawIndices, rawIndices + count));
+            });
+        return id;
+    }
+
+    ComponentTypeId typeId() const override
+    {
+        return staticTypeId();
+    }
+
+    bool release(uint64_t& rawIndex) override
+    {
+        if (!owning) {
+            return false;
+        }
+        owning = false;
+        rawIndex = index.toInt();
+        return true;
+    }
+
+    uint64_t getRawIndex() const override
+    {
+        return index.toInt();
     }
 
-    ComponentType& get()
+    decltype(auto) get()
     {
         return SystemClass::instance->get(index);
     }
@@ -61,7 +112,7 @@ public:
 
 private:
     IndexType index;
-    bool valid;
+    bool owning;
 };
 
 #endif //_component_h
\ No newline at end of file
@@ -13,26 +13,53 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "entity.h"
+#include "entitymanager.h"
 
+#include "SDL.h"
 #include "python/python.h"
 #include <pybind11/stl.h>
 
 #include <iostream>
 
 Entity::Entity()
-    : components()
+    : entityId()
     , isDestroyed(false)
 {
+    entityId = EntityManager::instance->store.create();
+}
+
+Entity::~Entity()
+{
+    // no manager, no store. the store took the components down with it already
+    if (EntityManager::instance) {
+        EntityManager::instance->store.destroy(entityId);
+    }
 }
 
 void Entity::addComponent(ComponentWrapperBasePtr component)
 {
-    components.push_back(component);
+    if (!component) {
+        return;
+    }
+
+    uint64_t rawIndex = 0;
+    if (!component->release(rawIndex)) {
+        SDL_Log("Component was added to an entity before, ignoring it");
+        return;
+    }
+
+    EntityManager::instance->store.addComponent(entityId, component->typeId(), rawIndex);
 }
 
 void Entity::destroy()
 {
+    if (isDestroyed) {
+        return;
+    }
+
+    // actually goes away at the next EntityManager update
     isDestroyed = true;
+    EntityManager::instance->queueDestroy(*this);
 }
 
 bool Entity::getIsDestroyed() const
@@ -40,6 +67,11 @@ bool Entity::getIsDestroyed() const
     return isDestroyed;
 }
 
+EntityId Entity::getEntityId() const
+{
+    return entityId;
+}
+
 class PyEntity : public PyEntityBase<> {
 public:
     using PyEntityBase<>::PyEntityBase;
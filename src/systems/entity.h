@@ -18,22 +18,26 @@
 #include <memory>
 #include <python/python.h>
 
+#include "archetype.h"
 #include "component.h"
 
 class Entity {
 public:
     Entity();
-    virtual ~Entity() = default;
+    virtual ~Entity();
 
     int id = -1;
 
+    // the entity takes over the component. the wrapper stays usable as a handle
     void addComponent(ComponentWrapperBasePtr component);
 
     void destroy();
     bool getIsDestroyed() const;
+    EntityId getEntityId() const;
 
 private:
-    std::vector<ComponentWrapperBasePtr> components;
+    // the row in the entity managers archetype store, which owns the components
+    EntityId entityId;
     bool isDestroyed;
 };
 using EntityPtr = std::shared_ptr<Entity>;
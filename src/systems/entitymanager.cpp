@@ -20,6 +20,7 @@ void EntityManager::addEntity(EntityPtr& ptr)
 {
     entites.push_back(ptr);
     ptr->id = static_cast<int>(entites.size() - 1);
+    setEntitySlot(ptr, ptr->id);
 }
 
 void EntityManager::removeEntity(EntityPtr& ptr)
@@ -30,6 +31,7 @@ void EntityManager::removeEntity(EntityPtr& ptr)
 
     int oldId = ptr->id;
     ptr->id = -1;
+    setEntitySlot(ptr, -1);
     if (oldId == (entites.size() - 1)) {
         entites.pop_back();
         return;
@@ -38,16 +40,80 @@ void EntityManager::removeEntity(EntityPtr& ptr)
     entites[oldId].reset();
     entites[oldId] = *entites.rbegin();
     entites[oldId]->id = oldId;
+    setEntitySlot(entites[oldId], oldId);
     entites.pop_back();
 }
 
-void EntityManager::update(double dt)
+EntityPtr EntityManager::getEntity(const EntityId& entityId) const
+{
+    if (entityId.index >= entitySlots.size()) {
+        return nullptr;
+    }
+
+    int position = entitySlots[entityId.index];
+    if (position < 0 || position >= entites.size() || !(entites[position]->getEntityId() == entityId)) {
+        return nullptr;
+    }
+    return entites[position];
+}
+
+EntityPtr EntityManager::ownerOf(const ComponentWrapperBase& component) const
+{
+    EntityId entityId;
+    if (!store.ownerOf(component.typeId(), component.getRawIndex(), entityId)) {
+        return nullptr;
+    }
+    return getEntity(entityId);
+}
+
+void EntityManager::setEntitySlot(const EntityPtr& ptr, int position)
+{
+    uint32_t slot = ptr->getEntityId().index;
+    if (slot >= entitySlots.size()) {
+        entitySlots.resize(slot + 1, -1);
+    }
+    entitySlots[slot] = position;
+}
+
+void EntityManager::queueDestroy(Entity& entity)
 {
-    for (auto&& e : entites) {
-        if (e->getIsDestroyed()) {
-            removeEntity(e);
+    PendingDestroy pending;
+    if (entity.id >= 0 && entity.id < entites.size()) {
+        pending.entity = entites[entity.id];
+    }
+    pending.entityId = entity.getEntityId();
+    pendingDestroy.push_back(pending);
+}
+
+void EntityManager::queueDestroy(const EntityId& entityId)
+{
+    PendingDestroy pending;
+    pending.entityId = entityId;
+    pendingDestroy.push_back(pending);
+}
+
+void EntityManager::flushDestroyed()
+{
+    flushing.swap(pendingDestroy);
+    flushingIds.clear();
+
+    for (auto&& pending : flushing) {
+        if (pending.entity && pending.entity->id >= 0) {
+            removeEntity(pending.entity);
         }
+        flushingIds.push_back(pending.entityId);
     }
+
+    // components of all of them at once, grouped by system
+    store.destroy(flushingIds);
+
+    // last references to the entities go here. anything destroyed in the process waits for the next flush
+    flushing.clear();
+}
+
+void EntityManager::update(double dt)
+{
+    flushDestroyed();
 }
 
 std::shared_ptr<EntityManager> EntityManager::instance(nullptr);
@@ -59,6 +125,16 @@ public:
         py::class_<EntityManager, std::shared_ptr<EntityManager>> em(m, "EntityManager");
         em.def("addEntity", &EntityManager::addEntity);
         em.def("removeEntity", &EntityManager::removeEntity);
+        // the entity a component was added to, or None
+        em.def("ownerOf", [](EntityManager& manager, const ComponentWrapperBasePtr& component) {
+            return component ? manager.ownerOf(*component) : nullptr;
+        });
+        // the ints Prefab.instantiate hands out
+        em.def("destroyEntities", [](EntityManager& manager, const std::vector<uint64_t>& entityIds) {
+            for (auto&& entityId : entityIds) {
+                manager.queueDestroy(EntityId(entityId));
+            }
+        });
         m.attr("entityManager") = EntityManager::instance;
     }
 };
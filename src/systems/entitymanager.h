@@ -13,9 +13,10 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #ifndef _entitymanager_h
-#define _entitymanger_h
+#define _entitymanager_h
 
 #include "entity.h"
+#include "schedule.h"
 #include <vector>
 
 class EntityManager {
@@ -24,10 +25,46 @@ public:
 
     void removeEntity(EntityPtr& ptr);
 
+    // The python entity for an id, null for prefab instances and entities that were never added
+    EntityPtr getEntity(const EntityId& entityId) const;
+    // who owns a component, without searching. false if nobody does
+    template <class Component>
+    bool ownerOf(const typename Component::IndexType& index, EntityId& entityId) const
+    {
+        return store.ownerOf(Component::staticTypeId(), index.toInt(), entityId);
+    }
+    EntityPtr ownerOf(const ComponentWrapperBase& component) const;
+
+    // for Entity::destroy
+    void queueDestroy(Entity& entity);
+    // entities without a python side (prefab instances)
+    void queueDestroy(const EntityId& entityId);
+    // tears down everything queued so far. update does this, its the sync point for destruction
+    void flushDestroyed();
+
+    // python
+    static constexpr SystemAccess access = { 0, StoreAll, true };
     void update(double dt);
 
+    // declared first, so it outlives the entities below and takes the remaining components down last
+    ArchetypeStore store;
     std::vector<EntityPtr> entites;
     static std::shared_ptr<EntityManager> instance;
+
+private:
+    struct PendingDestroy {
+        // null if the entity was never added
+        EntityPtr entity;
+        EntityId entityId;
+    };
+    // EntityId slot -> position in entites, -1 if not in there
+    std::vector<int> entitySlots;
+    void setEntitySlot(const EntityPtr& ptr, int position);
+
+    std::vector<PendingDestroy> pendingDestroy;
+    // swapped with pendingDestroy while flushing, so both keep their memory
+    std::vector<PendingDestroy> flushing;
+    std::vector<EntityId> flushingIds;
 };
 
-#endif //_entitymanger_h
\ No newline at end of file
+#endif //_entitymanager_h
\ No newline at end of file
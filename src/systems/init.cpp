@@ -13,6 +13,9 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "systems/init.h"
+#include "runtime/fixedtimestep.h"
+#include "runtime/jobs.h"
+#include "runtime/profiler.h"
 #include "systems/animation.h"
 #include "systems/camera.h"
 #include "systems/collision.h"
@@ -20,12 +23,25 @@
 #include "systems/input.h"
 #include "systems/simplephysics.h"
 #include "systems/render.h"
+#include "systems/schedule.h"
 #include "systems/tick.h"
 #include "systems/tilemap.h"
 #include "systems/transform.h"
 
+static std::unique_ptr<SystemSchedule> schedule;
+static FixedTimestep fixedTimestep;
+
+// adds a system to the schedule under its access declaration
+template <class System>
+static void addSystem(const std::string& name, SystemPhase phase)
+{
+    schedule->add(name, System::access, phase, [](double dt) { System::instance->update(dt); });
+}
+
 void initSystems()
 {
+    // workers for the system updates. the thread that gets here is the main thread
+    JobSystem::instance = std::make_shared<JobSystem>();
 
     TransformSystem::instance = std::make_shared<TransformSystem>();
     CameraSystem::instance = std::make_shared<CameraSystem>();
@@ -41,6 +57,19 @@ void initSystems()
     // and these ones might hold some entity callbacks
     InputSystem::instance = std::make_shared<InputSystem>();
     TickSystem::instance = std::make_shared<TickSystem>();
+
+    // preferred order. the schedule only keeps the parts of it that matter
+    schedule.reset(new SystemSchedule);
+    addSystem<InputSystem>("Input", SystemPhase::Early);
+    addSystem<EntityManager>("EntityManager", SystemPhase::Early);
+    addSystem<CollisionSystem>("Collision", SystemPhase::Fixed);
+    addSystem<SimplePhysicsSystem>("SimplePhysics", SystemPhase::Fixed);
+    // in the fixed steps, so it overlaps collision and physics. it only touches animations and sprites
+    addSystem<AnimationSystem>("Animation", SystemPhase::Fixed);
+    addSystem<TickSystem>("Tick", SystemPhase::Fixed);
+    addSystem<RenderSystem>("Render", SystemPhase::Late);
+    addSystem<TilemapSystem>("Tilemap", SystemPhase::Late);
+    schedule->build();
 }
 
 void finishSystemsEarly()
@@ -52,6 +81,8 @@ void finishSystemsEarly()
 
 void finishSystems()
 {
+    schedule.reset();
+
     // this thing can hold references to all the others, so destroy first and init last
     EntityManager::instance.reset();
 
@@ -68,6 +99,8 @@ void finishSystems()
     // callbacks should (*prays*) not hold any references to anything else
     InputSystem::instance.reset();
     TickSystem::instance.reset();
+
+    JobSystem::instance.reset();
 }
 
 void processEvent(const SDL_Event& event)
@@ -77,12 +110,27 @@ void processEvent(const SDL_Event& event)
 
 void updateSystems(double dt)
 {
-    InputSystem::instance->update(dt);
-    CollisionSystem::instance->update(dt);
-    EntityManager::instance->update(dt);
-    SimplePhysicsSystem::instance->update(dt);
-    TickSystem::instance->update(dt);
-    AnimationSystem::instance->update(dt);
-    RenderSystem::instance->update(dt);
-    TilemapSystem::instance->update(dt);
+    auto& jobs = *JobSystem::instance;
+    {
+        PROFILE_SCOPE("Early systems");
+        schedule->run(jobs, dt, SystemPhase::Early);
+    }
+
+    // the simulation only ever sees the fixed dt, however long the frame took
+    int steps = fixedTimestep.advance(dt);
+    for (int i = 0; i < steps; i++) {
+        PROFILE_SCOPE("Fixed step");
+        TransformSystem::instance->getStorage().savePrevious();
+        schedule->run(jobs, fixedTimestep.getStep(), SystemPhase::Fixed);
+    }
+    TransformSystem::instance->setInterpolation(static_cast<float>(fixedTimestep.getAlpha()));
+
+    PROFILE_SCOPE("Late systems");
+    schedule->run(jobs, dt, SystemPhase::Late);
+}
+
+void setFixedTimestep(double step, int maxSteps)
+{
+    fixedTimestep.setStep(step);
+    fixedTimestep.setMaxSteps(maxSteps);
 }
\ No newline at end of file
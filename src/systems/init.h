@@ -24,5 +24,7 @@ void finishSystems();
 void processEvent(const SDL_Event& event);
 
 void updateSystems(double dt);
+// simulation rate, and how many steps a single frame may catch up before time is dropped
+void setFixedTimestep(double step, int maxSteps);
 
 #endif //_system_init_h
\ No newline at end of file
@@ -20,6 +20,7 @@ namespace xml = tinyxml2;
 #include <imgui.h>
 
 #include "runtime/filename.h"
+#include "runtime/profiler.h"
 #include "util/xmlhelpers.h"
 
 std::shared_ptr<InputSystem> InputSystem::instance(nullptr);
@@ -128,8 +129,14 @@ void InputSystem::remove(const IndexType& i)
     inputs.remove(i);
 }
 
+void InputSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    inputs.removeMany(indices);
+}
+
 void InputSystem::processEvent(const SDL_Event& e)
 {
+    PROFILE_SCOPE("Input dispatch");
     // events we process out of this event go in here.
     // might be more than one
     // example: sdl events will always result in "keyup" and "keydown"
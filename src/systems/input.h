@@ -16,6 +16,7 @@
 #define _systems_input_h
 
 #include "systems/component.h"
+#include "systems/schedule.h"
 #include <pybind11/functional.h>
 #include <SDL.h>
 #include <functional>
@@ -50,8 +51,11 @@ public:
     IndexType create(const std::string& name, const py::function& callback);
     Input& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
 
     void processEvent(const SDL_Event& e);
+    // python callbacks
+    static constexpr SystemAccess access = { 0, StoreAll, true };
     void update(double dt);
 
     void earlyCleanup();
@@ -0,0 +1,237 @@
+/*
+    prefab.cpp: entity templates that are spawned natively
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "prefab.h"
+#include "entitymanager.h"
+#include "rendercomponents.h"
+
+#include "SDL.h"
+#include "python/python.h"
+#include "runtime/filename.h"
+#include "util/xmlhelpers.h"
+#include <algorithm>
+#include <array>
+#include <tinyxml2.h>
+
+namespace xml = tinyxml2;
+
+Prefab::Prefab()
+{
+    updateLayout();
+}
+
+Prefab::~Prefab()
+{
+    if (hasSprite && RenderSystem::instance) {
+        RenderSystem::instance->releaseTexture(texture);
+    }
+}
+
+Prefab::Ptr Prefab::load(const std::string& filename)
+{
+    xml::XMLDocument doc;
+    if (doc.LoadFile(filename.c_str()) != xml::XML_SUCCESS) {
+        SDL_Log("Cannot load prefab %s", filename.c_str());
+        return nullptr;
+    }
+
+    auto root = doc.FirstChildElement("prefab");
+    if (!root) {
+        SDL_Log("Prefab %s has no <prefab> tag", filename.c_str());
+        return nullptr;
+    }
+
+    Ptr prefab = std::make_shared<Prefab>();
+
+    if (auto tag = root->FirstChildElement("transform")) {
+        Transform2D transform;
+        transform.scale.x = tag->FloatAttribute("scalex", 1.0f);
+        transform.scale.y = tag->FloatAttribute("scaley", 1.0f);
+        transform.rotation = tag->DoubleAttribute("rotation", 0.0);
+        transform.flipHorizontal = tag->BoolAttribute("fliphorizontal", false);
+        transform.flipVertical = tag->BoolAttribute("flipvertical", false);
+        prefab->setTransform(transform);
+    }
+
+    if (auto tag = root->FirstChildElement("sprite")) {
+        std::string file = nullAwareAttr(tag->Attribute("file"));
+        if (file.empty()) {
+            SDL_Log("Prefab %s: sprites need 'file' set", filename.c_str());
+            return nullptr;
+        }
+        auto layer = static_cast<uint8_t>(tag->UnsignedAttribute("layer", 0));
+        if (!prefab->setSprite(Filename::gameFile(file), layer)) {
+            return nullptr;
+        }
+    }
+
+    if (auto tag = root->FirstChildElement("collider")) {
+        FRect aabb;
+        aabb.x = tag->FloatAttribute("x", 0.0f);
+        aabb.y = tag->FloatAttribute("y", 0.0f);
+        aabb.w = tag->FloatAttribute("w", 0.0f);
+        aabb.h = tag->FloatAttribute("h", 0.0f);
+        prefab->setCollider(aabb, static_cast<uint64_t>(tag->Int64Attribute("mask", 0)));
+    }
+
+    if (auto tag = root->FirstChildElement("physics")) {
+        SimplePhysicsObject physics;
+        physics.velocity = glm::vec2(tag->FloatAttribute("vx", 0.0f), tag->FloatAttribute("vy", 0.0f));
+        physics.acceleration = glm::vec2(tag->FloatAttribute("ax", 0.0f), tag->FloatAttribute("ay", 0.0f));
+        physics.gravity = glm::vec2(tag->FloatAttribute("gx", 0.0f), tag->FloatAttribute("gy", 0.0f));
+        physics.maxVelocity = glm::vec2(tag->FloatAttribute("maxvx", 0.0f), tag->FloatAttribute("maxvy", 0.0f));
+        prefab->setPhysics(physics);
+    }
+
+    return prefab;
+}
+
+void Prefab::setTransform(const Transform2D& newTransform)
+{
+    transform = newTransform;
+    updateLayout();
+}
+
+bool Prefab::setSprite(const std::string& filename, uint8_t newLayer)
+{
+    RenderSystem::TextureIndexType newTexture;
+    if (!RenderSystem::instance->loadTexture(filename, newTexture)) {
+        return false;
+    }
+
+    // retain first, the old and the new one might be the same
+    RenderSystem::instance->retainTexture(newTexture);
+    if (hasSprite) {
+        RenderSystem::instance->releaseTexture(texture);
+    }
+
+    hasSprite = true;
+    texture = newTexture;
+    layer = newLayer;
+    updateLayout();
+    return true;
+}
+
+void Prefab::setCollider(const FRect& newAabb, uint64_t newMask)
+{
+    hasCollider = true;
+    aabb = newAabb;
+    mask = newMask;
+    updateLayout();
+}
+
+void Prefab::setPhysics(const SimplePhysicsObject& newPhysics)
+{
+    hasPhysics = true;
+    physics = newPhysics;
+    updateLayout();
+}
+
+void Prefab::instantiate(const std::vector<glm::vec2>& positions, std::vector<EntityId>& entities)
+{
+    instantiate(positions, std::vector<glm::vec2>(), entities);
+}
+
+void Prefab::instantiate(const std::vector<glm::vec2>& positions, const std::vector<glm::vec2>& velocities, std::vector<EntityId>& entities)
+{
+    auto& store = EntityManager::instance->store;
+    store.reserve(signature, positions.size());
+    entities.reserve(entities.size() + positions.size());
+
+    std::array<uint64_t, PartCount> parts;
+    std::array<uint64_t, PartCount> components;
+    for (size_t i = 0; i < positions.size(); i++) {
+        Transform2D instanceTransform = transform;
+        instanceTransform.position = positions[i];
+        auto transformId = TransformSystem::instance->create(instanceTransform);
+        parts[PartTransform] = transformId.toInt();
+
+        if (hasSprite) {
+            parts[PartSprite] = RenderSystem::instance->createSprite(transformId, texture, layer).toInt();
+        }
+
+        auto colliderId = CollisionSystem::IndexType();
+        if (hasCollider) {
+            colliderId = CollisionSystem::instance->create(transformId, aabb, mask);
+            parts[PartCollider] = colliderId.toInt();
+        }
+
+        if (hasPhysics) {
+            auto physicsId = SimplePhysicsSystem::instance->create(transformId, colliderId, hasCollider);
+            auto& object = SimplePhysicsSystem::instance->get(physicsId);
+            object.velocity = i < velocities.size() ? velocities[i] : physics.velocity;
+            object.acceleration = physics.acceleration;
+            object.gravity = physics.gravity;
+            object.maxVelocity = physics.maxVelocity;
+            parts[PartPhysics] = physicsId.toInt();
+        }
+
+        for (size_t column = 0; column < columns.size(); column++) {
+            components[column] = parts[columns[column]];
+        }
+        entities.push_back(store.create(signature, components.data()));
+    }
+}
+
+void Prefab::updateLayout()
+{
+    std::vector<std::pair<ComponentTypeId, Part>> layout;
+    layout.push_back(std::make_pair(TransformComponent::staticTypeId(), PartTransform));
+    if (hasSprite) {
+        layout.push_back(std::make_pair(SpriteComponent::staticTypeId(), PartSprite));
+    }
+    if (hasCollider) {
+        layout.push_back(std::make_pair(CollisionComponent::staticTypeId(), PartCollider));
+    }
+    if (hasPhysics) {
+        layout.push_back(std::make_pair(SimplePhysicsComponent::staticTypeId(), PartPhysics));
+    }
+    // the store wants the signature sorted
+    std::sort(layout.begin(), layout.end());
+
+    signature.clear();
+    columns.clear();
+    for (auto&& entry : layout) {
+        signature.push_back(entry.first);
+        columns.push_back(entry.second);
+    }
+}
+
+class PyPrefab {
+public:
+    static void initModule(py::module& m)
+    {
+        py::class_<Prefab, Prefab::Ptr> c(m, "Prefab");
+        c
+            .def(py::init<>())
+            .def_static("load", &Prefab::load)
+            .def("setTransform", &Prefab::setTransform)
+            .def("setSprite", &Prefab::setSprite)
+            .def("setCollider", &Prefab::setCollider, py::arg("aabb"), py::arg("mask") = 0)
+            .def("setPhysics", &Prefab::setPhysics)
+            // entity ids as ints, for EntityManager.destroyEntities
+            .def("instantiate", [](Prefab& prefab, const std::vector<glm::vec2>& positions, const std::vector<glm::vec2>& velocities) {
+                std::vector<EntityId> entities;
+                prefab.instantiate(positions, velocities, entities);
+                std::vector<uint64_t> result;
+                result.reserve(entities.size());
+                for (auto&& entity : entities) {
+                    result.push_back(entity.toInt());
+                }
+                return result;
+            },
+                py::arg("positions"), py::arg("velocities") = std::vector<glm::vec2>());
+    }
+};
+PyType<Prefab, PyPrefab, Transform2D, FRect, SimplePhysicsObject, glm::vec2> pyprefab;
@@ -0,0 +1,89 @@
+/*
+    prefab.h: entity templates that are spawned natively
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_prefab_h
+#define _systems_prefab_h
+
+#include "systems/archetype.h"
+#include "systems/collision.h"
+#include "systems/render.h"
+#include "systems/simplephysics.h"
+#include "systems/transform.h"
+
+#include <glm/vec2.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A set of components, set up once and spawned as many times as needed in one call.
+// Textures are resolved when the prefab is set up, spawning does no filename lookups
+// and does not go through python once per component.
+// Spawned entities only live in the entity store, destroy them through the EntityManager.
+class Prefab {
+public:
+    using Ptr = std::shared_ptr<Prefab>;
+
+    // just a transform
+    Prefab();
+    ~Prefab();
+
+    Prefab(const Prefab&) = delete;
+    Prefab& operator=(const Prefab&) = delete;
+
+    // <prefab> with <transform>, <sprite>, <collider> and <physics> children. null if that does not work out
+    static Ptr load(const std::string& filename);
+
+    // the position is overwritten per instance
+    void setTransform(const Transform2D& transform);
+    // false if the texture cant be loaded, the prefab has no sprite then
+    bool setSprite(const std::string& filename, uint8_t layer);
+    void setCollider(const FRect& aabb, uint64_t mask = 0);
+    // transformId and colliderId are ignored, the rest is copied to every instance
+    void setPhysics(const SimplePhysicsObject& physics);
+
+    // one entity per position, appended to entities
+    void instantiate(const std::vector<glm::vec2>& positions, std::vector<EntityId>& entities);
+    // same, with a starting velocity per entity. needs physics
+    void instantiate(const std::vector<glm::vec2>& positions, const std::vector<glm::vec2>& velocities, std::vector<EntityId>& entities);
+
+private:
+    enum Part : size_t {
+        PartTransform,
+        PartSprite,
+        PartCollider,
+        PartPhysics,
+        PartCount
+    };
+
+    // signature and which part goes into which column, redone when parts change
+    void updateLayout();
+
+    Transform2D transform;
+
+    bool hasSprite = false;
+    RenderSystem::TextureIndexType texture;
+    uint8_t layer = 0;
+
+    bool hasCollider = false;
+    FRect aabb;
+    uint64_t mask = 0;
+
+    bool hasPhysics = false;
+    SimplePhysicsObject physics;
+
+    Signature signature;
+    std::vector<Part> columns;
+};
+
+#endif // _systems_prefab_h
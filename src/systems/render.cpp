@@ -16,11 +16,15 @@
 
 #include "runtime/window.h"
 #include "systems/camera.h"
+#include "systems/rendergrid.h"
+#include "systems/spriterenderer.h"
 #include "util/slotmap.h"
 #include <GL/gl3w.h>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <tuple>
 
 class TextureWrapper {
 public:
@@ -30,6 +34,14 @@ public:
             return;
         }
 
+        // nothing to upload to, but sizes are still good for source rects
+        if (!Window::renderer) {
+            rawData.width = static_cast<uint32_t>(surface->w);
+            rawData.height = static_cast<uint32_t>(surface->h);
+            SDL_FreeSurface(surface);
+            return;
+        }
+
         tex = SDL_CreateTextureFromSurface(Window::renderer, surface);
         if (!tex) {
             SDL_Log("Cannot create Texture Wrapper %s", SDL_GetError());
@@ -43,6 +55,8 @@ public:
         rawData.width = static_cast<uint32_t>(surface->w);
         rawData.height = static_cast<uint32_t>(surface->h);
         SDL_GL_UnbindTexture(tex);
+        // the gl sprite renderer needs to know how SDL stored it
+        SDL_QueryTexture(tex, &format, nullptr, nullptr, nullptr);
 
         SDL_FreeSurface(surface);
     }
@@ -52,6 +66,7 @@ public:
         tex = other.tex;
         other.tex = nullptr;
         rawData = other.rawData;
+        format = other.format;
     }
 
     TextureWrapper(const TextureWrapper& other) = delete;
@@ -73,9 +88,36 @@ public:
 
     SDL_Texture* tex = nullptr;
     RawTextureData rawData;
+    Uint32 format = 0;
     int refcount = 0;
 };
 
+// Where a sprite or batch is in the grid, and the transform and shape that got it there.
+// The cells only get worked out again when one of those is different or the thing was handed out since.
+// python holds on to sprites and batches, so handing out alone does not catch every change
+struct GridPlacement {
+    RenderGrid::CellRange cells;
+    glm::vec2 position = glm::vec2(0.0f);
+    glm::vec2 previousPosition = glm::vec2(0.0f);
+    glm::vec2 scale = glm::vec2(0.0f);
+    double rotation = 0.0;
+    // sprite offset and source size, or batch boundary
+    glm::vec2 offset = glm::vec2(0.0f);
+    glm::ivec2 size = glm::ivec2(0);
+    bool dirty = true;
+};
+
+// A batch as draw items relative to its position, so drawing it is only moving them.
+// Goes stale when the batch is handed out by getBatch or the transform scale or rotation changed
+struct BatchCache {
+    bool valid = false;
+    glm::vec2 scale = glm::vec2(1.0f);
+    double rotation = 0.0;
+    std::vector<DrawItem> items;
+    // the same items in a gl buffer, with the gl backend
+    uint32_t buffer = 0;
+};
+
 class RenderSystemData {
 public:
     // the textures
@@ -86,21 +128,127 @@ public:
     using SpriteList = SlotMap<Sprite>;
     using SpriteBatchList = SlotMap<SpriteBatch>;
     struct TextureEntry {
+        TextureMap::IndexType texture;
         SpriteList sprites;
         SpriteBatchList batches;
+        // the grid cells of every sprite and batch, by slot
+        std::vector<GridPlacement> spritePlacements;
+        std::vector<GridPlacement> batchPlacements;
+        // baked batches, by slot
+        std::vector<BatchCache> batchCaches;
     };
 
-    // a layer, sorted per texture
-    using SpriteLayer = std::unordered_map<TextureMap::IndexType, std::unique_ptr<TextureEntry>>;
+    // a layer, one entry per texture sorted by texture id. so the draw order within a layer is always the same
+    using SpriteLayer = std::vector<TextureEntry>;
     // all the layers
-    using Layers = std::array<SpriteLayer, 255>;
+    using Layers = std::array<SpriteLayer, 256>;
     Layers layers;
+    // the layers that have anything in them, in draw order
+    std::vector<uint8_t> activeLayers;
 
     SlotMap<RenderSystem::UniqueSpriteIndex> lookup;
     SlotMap<RenderSystem::UniqueBatchIndex> lookupBatch;
 
     // filename->texture association
     std::map<std::string, TextureMap::IndexType> filenames;
+
+    // where everything is, cameras only draw what they find in here
+    RenderGrid grid;
+    // what one camera found in the grid, and the sprites of one texture that made it through culling. reused
+    std::vector<RenderKey> visible;
+    std::vector<DrawItem> drawItems;
+
+    // sprites straight through gl instead of SDL_RenderCopyExF, when turned on
+    GLSpriteRenderer glSprites;
+    bool glBackend = false;
+
+    ~RenderSystemData()
+    {
+        releaseBaked();
+    }
+
+    // rebuilt the next time the batch is drawn
+    void invalidate(BatchCache& cache)
+    {
+        cache.valid = false;
+        glSprites.releaseBaked(cache.buffer);
+        cache.buffer = 0;
+    }
+
+    // the gl buffers of all batch caches, before the gl sprite renderer goes away. the items stay
+    void releaseBaked()
+    {
+        for (auto&& layer : activeLayers) {
+            for (auto&& entry : layers[layer]) {
+                for (auto&& cache : entry.batchCaches) {
+                    glSprites.releaseBaked(cache.buffer);
+                    cache.buffer = 0;
+                }
+            }
+        }
+    }
+
+    static bool textureBefore(const TextureEntry& entry, const TextureMap::IndexType& texture)
+    {
+        return std::make_pair(entry.texture.index, entry.texture.generation) < std::make_pair(texture.index, texture.generation);
+    }
+
+    // nullptr if nothing in that layer uses the texture. only good until the next entry is added or dropped
+    TextureEntry* findEntry(uint8_t layer, const TextureMap::IndexType& texture)
+    {
+        auto& entries = layers[layer];
+        auto iter = std::lower_bound(entries.begin(), entries.end(), texture, textureBefore);
+        if (iter == entries.end() || !(iter->texture == texture)) {
+            return nullptr;
+        }
+        return &*iter;
+    }
+
+    TextureEntry& findOrAddEntry(uint8_t layer, const TextureMap::IndexType& texture)
+    {
+        auto& entries = layers[layer];
+        auto iter = std::lower_bound(entries.begin(), entries.end(), texture, textureBefore);
+        if (iter != entries.end() && iter->texture == texture) {
+            return *iter;
+        }
+
+        if (entries.empty()) {
+            activeLayers.insert(std::lower_bound(activeLayers.begin(), activeLayers.end(), layer), layer);
+        }
+        iter = entries.emplace(iter);
+        iter->texture = texture;
+        return *iter;
+    }
+
+    // drops the entry once nothing in it is left, and the layer with the last entry
+    void dropIfEmpty(uint8_t layer, const TextureMap::IndexType& texture)
+    {
+        auto& entries = layers[layer];
+        auto iter = std::lower_bound(entries.begin(), entries.end(), texture, textureBefore);
+        if (iter == entries.end() || !(iter->texture == texture) || !iter->sprites.empty() || !iter->batches.empty()) {
+            return;
+        }
+
+        entries.erase(iter);
+        if (entries.empty()) {
+            activeLayers.erase(std::lower_bound(activeLayers.begin(), activeLayers.end(), layer));
+        }
+    }
+
+    // takes a removed sprite or batch out of the grid
+    void forget(const RenderKey& key, TextureEntry& entry)
+    {
+        auto& placements = key.batch ? entry.batchPlacements : entry.spritePlacements;
+        if (key.entry.index < placements.size()) {
+            grid.remove(key, placements[key.entry.index].cells);
+            placements[key.entry.index] = GridPlacement();
+        }
+        if (key.batch && key.entry.index < entry.batchCaches.size()) {
+            auto& cache = entry.batchCaches[key.entry.index];
+            invalidate(cache);
+            cache.items = std::vector<DrawItem>();
+        }
+    }
 };
 
 std::shared_ptr<RenderSystem> RenderSystem::instance(nullptr);
@@ -120,37 +268,72 @@ RenderSystem::IndexType RenderSystem::createSprite(const TransformComponent& tra
     return createSprite(transformComponent.getIndex(), filename, layer);
 }
 
-RenderSystem::IndexType RenderSystem::createSprite(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer)
+bool RenderSystem::loadTexture(const std::string& filename, TextureIndexType& texture)
 {
-    Sprite newSprite;
-
+    // the texture might be gone since, the last sprite using it took it along
     auto filenameIter = data->filenames.find(filename);
-    if (filenameIter == data->filenames.end()) {
-        auto img = IMG_Load(filename.c_str());
-        if (!img) {
-            SDL_Log("Cannot open file %s - %s", filename.c_str(), IMG_GetError());
-            return RenderSystem::IndexType();
+    if (filenameIter != data->filenames.end() && data->textures.find(filenameIter->second) != data->textures.end()) {
+        texture = filenameIter->second;
+        return true;
+    }
+
+    auto img = IMG_Load(filename.c_str());
+    if (!img) {
+        SDL_Log("Cannot open file %s - %s", filename.c_str(), IMG_GetError());
+        return false;
+    }
+
+    texture = data->textures.emplace(img);
+    data->filenames[filename] = texture;
+    return true;
+}
+
+void RenderSystem::retainTexture(const TextureIndexType& texture)
+{
+    if (auto textureIter = data->textures.find(texture); textureIter != data->textures.end()) {
+        textureIter->refcount++;
+    }
+}
+
+void RenderSystem::releaseTexture(const TextureIndexType& texture)
+{
+    if (auto textureIter = data->textures.find(texture); textureIter != data->textures.end()) {
+        textureIter->refcount--;
+        if (textureIter->refcount <= 0) {
+            data->textures.remove(texture);
         }
-        // FIXME: does this really need to default? probably yes.
-        newSprite.source.w = img->w;
-        newSprite.source.h = img->h;
+    }
+}
 
-        auto texId = data->textures.emplace(img);
-        filenameIter = data->filenames.insert(std::make_pair(filename, texId)).first;
+RenderSystem::IndexType RenderSystem::createSprite(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer)
+{
+    TextureIndexType texId;
+    if (!loadTexture(filename, texId)) {
+        return RenderSystem::IndexType();
     }
-    auto texId = filenameIter->second;
 
-    data->textures[texId].refcount += 1;
+    return createSprite(transformId, texId, layer);
+}
 
-    auto& drawLayer = data->layers[layer];
-    auto textureLayer = drawLayer.find(texId);
-    if (textureLayer == drawLayer.end()) {
-        textureLayer = drawLayer.insert(std::make_pair(texId, new RenderSystemData::TextureEntry())).first;
+RenderSystem::IndexType RenderSystem::createSprite(const TransformSystem::IndexType& transformId, const TextureIndexType& texId, uint8_t layer)
+{
+    auto textureIter = data->textures.find(texId);
+    if (textureIter == data->textures.end()) {
+        SDL_Log("Creating a sprite with a texture that is gone");
+        return RenderSystem::IndexType();
     }
+    textureIter->refcount += 1;
+
+    Sprite newSprite;
+    // FIXME: does this really need to default? probably yes.
+    newSprite.source.w = static_cast<int>(textureIter->getRawTextureData().width);
+    newSprite.source.h = static_cast<int>(textureIter->getRawTextureData().height);
+
+    auto& entry = data->findOrAddEntry(layer, texId);
 
     newSprite.transformId = transformId;
 
-    auto spriteIndex = textureLayer->second->sprites.insert(std::move(newSprite));
+    auto spriteIndex = entry.sprites.insert(std::move(newSprite));
     UniqueSpriteIndex index;
     index.texture = texId.toInt();
     index.entry = spriteIndex.toInt();
@@ -164,11 +347,13 @@ Sprite& RenderSystem::getSprite(const IndexType& i)
     auto& index = data->lookup[i];
     RenderSystemData::TextureMap::IndexType texId(index.texture);
     RenderSystemData::SpriteList::IndexType spriteId(index.entry);
-    auto& layer = data->layers[index.layer];
-    auto& spriteLayer = layer.find(texId);
-    auto& sprite = spriteLayer->second->sprites.find(spriteId);
+    auto entry = data->findEntry(index.layer, texId);
+    // whoever asks might change the size or the transform
+    if (spriteId.index < entry->spritePlacements.size()) {
+        entry->spritePlacements[spriteId.index].dirty = true;
+    }
 
-    return *sprite;
+    return entry->sprites[spriteId];
 }
 
 void RenderSystem::removeSprite(const IndexType& i)
@@ -176,16 +361,17 @@ void RenderSystem::removeSprite(const IndexType& i)
     auto& index = data->lookup[i];
     RenderSystemData::TextureMap::IndexType texId(index.texture);
     RenderSystemData::SpriteList::IndexType spriteId(index.entry);
-    auto& layer = data->layers[index.layer];
     auto& textures = data->textures;
-    auto spriteLayerIter = layer.find(texId);
+    auto entry = data->findEntry(index.layer, texId);
     auto textureIter = textures.find(texId);
     // is that even a texture in the layer
-    if (spriteLayerIter != layer.end()) {
-        auto& sprites = spriteLayerIter->second->sprites;
+    if (entry) {
+        auto& sprites = entry->sprites;
         // that sprite is still alive my friend
         if (sprites.find(spriteId) != sprites.end()) {
             sprites.remove(spriteId);
+            data->forget({ index.layer, false, texId, spriteId }, *entry);
+            data->dropIfEmpty(index.layer, texId);
             // make sure the texture still actually exsists
             if (textureIter != textures.end()) {
                 textureIter->refcount--;
@@ -195,37 +381,97 @@ void RenderSystem::removeSprite(const IndexType& i)
             }
         }
     }
+    data->lookup.remove(i);
 }
 
-RenderSystem::BatchIndexType RenderSystem::createBatch(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer, const std::vector<BatchSprite>& inBatch)
+// Removes a bunch of sprites or batches grouped by layer and texture, so every list and refcount
+// is only touched once per group. listOf picks the sprite or batch list out of a TextureEntry
+template <class Lookup, class ListOf>
+static void removeGrouped(RenderSystemData& data, Lookup& lookup, const std::vector<SlotMapIndex>& indices, bool batches, ListOf listOf)
 {
-    SpriteBatch newBatch;
+    struct Removal {
+        uint8_t layer;
+        SlotMapIndex texture;
+        SlotMapIndex entry;
+    };
+    std::vector<Removal> removals;
+    removals.reserve(indices.size());
+    for (auto&& i : indices) {
+        auto iter = lookup.find(i);
+        if (iter != lookup.end()) {
+            removals.push_back({ iter->layer, SlotMapIndex(iter->texture), SlotMapIndex(iter->entry) });
+        }
+    }
 
-    auto filenameIter = data->filenames.find(filename);
-    if (filenameIter == data->filenames.end()) {
-        auto img = IMG_Load(filename.c_str());
-        if (!img) {
-            SDL_Log("Cannot open file %s - %s", filename.c_str(), IMG_GetError());
-            return RenderSystem::IndexType();
+    std::sort(removals.begin(), removals.end(), [](const Removal& a, const Removal& b) {
+        return std::make_tuple(a.layer, a.texture.toInt(), a.entry.index) < std::make_tuple(b.layer, b.texture.toInt(), b.entry.index);
+    });
+
+    std::vector<SlotMapIndex> entries;
+    for (size_t first = 0; first < removals.size();) {
+        const auto layerIndex = removals[first].layer;
+        const auto texId = removals[first].texture;
+        size_t last = first;
+        entries.clear();
+        for (; last < removals.size() && removals[last].layer == layerIndex && removals[last].texture == texId; last++) {
+            entries.push_back(removals[last].entry);
+        }
+        first = last;
+
+        auto entry = data.findEntry(layerIndex, texId);
+        if (!entry) {
+            continue;
+        }
+
+        // only the ones still alive count against the texture
+        auto& list = listOf(*entry);
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&list](const SlotMapIndex& entry) {
+            return list.find(entry) == list.end();
+        }),
+            entries.end());
+        list.removeMany(entries);
+        for (auto&& removed : entries) {
+            data.forget({ layerIndex, batches, texId, removed }, *entry);
         }
+        data.dropIfEmpty(layerIndex, texId);
 
-        auto texId = data->textures.emplace(img);
-        filenameIter = data->filenames.insert(std::make_pair(filename, texId)).first;
+        auto textureIter = data.textures.find(texId);
+        if (textureIter != data.textures.end()) {
+            textureIter->refcount -= static_cast<int>(entries.size());
+            if (textureIter->refcount <= 0) {
+                data.textures.remove(texId);
+            }
+        }
     }
-    auto texId = filenameIter->second;
 
-    data->textures[texId].refcount += 1;
+    lookup.removeMany(indices);
+}
 
-    auto& drawLayer = data->layers[layer];
-    auto textureLayer = drawLayer.find(texId);
-    if (textureLayer == drawLayer.end()) {
-        textureLayer = drawLayer.insert(std::make_pair(texId, new RenderSystemData::TextureEntry())).first;
+void RenderSystem::removeSprites(const std::vector<IndexType>& indices)
+{
+    removeGrouped(*data, data->lookup, indices, false, [](RenderSystemData::TextureEntry& entry) -> RenderSystemData::SpriteList& {
+        return entry.sprites;
+    });
+}
+
+RenderSystem::BatchIndexType RenderSystem::createBatch(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer, const std::vector<BatchSprite>& inBatch)
+{
+    SpriteBatch newBatch;
+
+    TextureIndexType texId;
+    if (!loadTexture(filename, texId)) {
+        return RenderSystem::IndexType();
     }
 
+    data->textures[texId].refcount += 1;
+
+    auto& entry = data->findOrAddEntry(layer, texId);
+
     newBatch.transformId = transformId;
     newBatch.batch = inBatch;
 
-    auto batchIndex = textureLayer->second->batches.insert(std::move(newBatch));
+    auto batchIndex = entry.batches.insert(std::move(newBatch));
     UniqueBatchIndex index;
     index.texture = texId.toInt();
     index.entry = batchIndex.toInt();
@@ -237,26 +483,32 @@ RenderSystem::BatchIndexType RenderSystem::createBatch(const TransformSystem::In
 SpriteBatch& RenderSystem::getBatch(const BatchIndexType& i)
 {
     auto& index = data->lookupBatch[i];
-    auto& layer = data->layers[index.layer];
-    auto& spriteLayer = layer.find(index.texture);
-    auto& batch = spriteLayer->second->batches.find(index.entry);
+    auto entry = data->findEntry(index.layer, index.texture);
+    // whoever asks might change it
+    if (index.entry.index < entry->batchCaches.size()) {
+        data->invalidate(entry->batchCaches[index.entry.index]);
+    }
+    if (index.entry.index < entry->batchPlacements.size()) {
+        entry->batchPlacements[index.entry.index].dirty = true;
+    }
 
-    return *batch;
+    return entry->batches[index.entry];
 }
 
 void RenderSystem::removeBatch(const BatchIndexType& i)
 {
     auto& index = data->lookupBatch[i];
-    auto& layer = data->layers[index.layer];
     auto& textures = data->textures;
-    auto spriteLayerIter = layer.find(index.texture);
+    auto entry = data->findEntry(index.layer, index.texture);
     auto textureIter = textures.find(index.texture);
     // is that even a texture in the layer
-    if (spriteLayerIter != layer.end()) {
-        auto& batches = spriteLayerIter->second->batches;
+    if (entry) {
+        auto& batches = entry->batches;
         // that sprite is still alive my friend
         if (batches.find(index.entry) != batches.end()) {
             batches.remove(index.entry);
+            data->forget({ index.layer, true, index.texture, index.entry }, *entry);
+            data->dropIfEmpty(index.layer, index.texture);
             // make sure the texture still actually exsists
             if (textureIter != textures.end()) {
                 textureIter->refcount--;
@@ -266,42 +518,205 @@ void RenderSystem::removeBatch(const BatchIndexType& i)
             }
         }
     }
+    data->lookupBatch.remove(i);
 }
 
-inline void drawOne(
-    const glm::vec2& camera,
-    const TextureWrapper& texture,
-    const Transform2D& transform,
-    const glm::vec2& offset,
-    const Rect& source,
-    bool hFlip,
-    bool vFlip)
+void RenderSystem::removeBatches(const std::vector<BatchIndexType>& indices)
 {
+    removeGrouped(*data, data->lookupBatch, indices, true, [](RenderSystemData::TextureEntry& entry) -> RenderSystemData::SpriteBatchList& {
+        return entry.batches;
+    });
+}
 
-    SDL_Rect srcRect;
-    srcRect.x = source.x;
-    srcRect.y = source.y;
-    srcRect.w = source.w;
-    srcRect.h = source.h;
-
-    SDL_FRect dstRect;
-    dstRect.x = roundf(transform.position.x + offset.x - camera.x);
-    dstRect.y = roundf(transform.position.y + offset.y - camera.y);
-    dstRect.w = roundf(transform.scale.x * static_cast<float>(srcRect.w));
-    dstRect.h = roundf(transform.scale.y * static_cast<float>(srcRect.h));
-
-    SDL_RenderCopyExF(
-        Window::renderer,
-        texture.tex,
-        &srcRect,
-        &dstRect,
-        transform.rotation,
-        nullptr,
-        hFlip ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE || vFlip ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE);
+void RenderSystem::shrinkToFit()
+{
+    // empty entries are already gone
+    for (auto&& layer : data->activeLayers) {
+        for (auto&& entry : data->layers[layer]) {
+            entry.sprites.shrinkToFit();
+            entry.batches.shrinkToFit();
+        }
+    }
+    data->lookup.shrinkToFit();
+    data->lookupBatch.shrinkToFit();
+}
+
+// One sprite of a batch, rounded the same way as single sprites.
+// Batches are culled as a whole, so there is no test here
+static DrawItem batchDrawItem(const BatchSprite& single, const glm::vec2& position, const Transform2DRef& transform, const glm::vec2& camera)
+{
+    DrawItem item;
+    item.source = { single.src.x, single.src.y, single.src.w, single.src.h };
+    item.destination.x = roundf(position.x + single.pos.x - camera.x);
+    item.destination.y = roundf(position.y + single.pos.y - camera.y);
+    item.destination.w = roundf(transform.scale.x * static_cast<float>(single.src.w));
+    item.destination.h = roundf(transform.scale.y * static_cast<float>(single.src.h));
+    item.rotation = transform.rotation;
+    item.flip = static_cast<SDL_RendererFlip>((single.hFlip ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE) | (single.vFlip ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE));
+    return item;
+}
+
+// The cache of a batch, baked again first if it went stale
+static BatchCache& batchCache(RenderSystemData& data, RenderSystemData::TextureEntry& entry, uint32_t slot, const SpriteBatch& batch, const Transform2DRef& transform)
+{
+    if (slot >= entry.batchCaches.size()) {
+        entry.batchCaches.resize(slot + 1);
+    }
+
+    auto& cache = entry.batchCaches[slot];
+    if (cache.valid && cache.scale == transform.scale && cache.rotation == transform.rotation) {
+        return cache;
+    }
+
+    data.invalidate(cache);
+    cache.items.clear();
+    for (auto&& single : batch.batch) {
+        cache.items.push_back(batchDrawItem(single, glm::vec2(0.0f), transform, glm::vec2(0.0f)));
+    }
+    cache.scale = transform.scale;
+    cache.rotation = transform.rotation;
+    cache.valid = true;
+    return cache;
+}
+
+// What a sprite covers in the world, as center and half size.
+// Rotation goes around the center, then the sprite fits into the circle around it
+static void spriteBounds(const Sprite& sprite, const glm::vec2& position, const glm::vec2& scale, double rotation, glm::vec2& center, glm::vec2& halfSize)
+{
+    glm::vec2 size = scale * glm::vec2(sprite.source.w, sprite.source.h);
+    halfSize = glm::abs(size) * 0.5f;
+    center = position + sprite.offset + size * 0.5f;
+    if (rotation != 0.0) {
+        halfSize = glm::vec2(glm::length(halfSize));
+    }
+}
+
+// cells for some bounds. really big things are cheaper to keep in the always visible list
+static RenderGrid::CellRange boundsCells(const RenderGrid& grid, const glm::vec2& min, const glm::vec2& max)
+{
+    const int64_t maxCells = 4096;
+    auto cells = grid.cellsOf(min, max);
+    if (static_cast<int64_t>(cells.x1 - cells.x0 + 1) * (cells.y1 - cells.y0 + 1) > maxCells) {
+        return RenderGrid::everywhere();
+    }
+    return cells;
+}
+
+// the part of a sprite or batch its cells depend on
+static void shapeOf(const Sprite& sprite, glm::vec2& offset, glm::ivec2& size)
+{
+    offset = sprite.offset;
+    size = glm::ivec2(sprite.source.w, sprite.source.h);
+}
+
+static void shapeOf(const SpriteBatch& batch, glm::vec2& offset, glm::ivec2& size)
+{
+    offset = glm::vec2(batch.boundary.x, batch.boundary.y);
+    size = glm::ivec2(batch.boundary.w, batch.boundary.h);
+}
+
+// Puts new, changed and moved sprites or batches into their cells, everything else is one compare.
+// The cells cover the previous and the current position, so they hold for any interpolation in between.
+// cellsOf gets the component and the placement with the transform filled in
+template <class List, class CellsOf>
+static void refreshPlacements(RenderGrid& grid, List& list, std::vector<GridPlacement>& placements, TransformStorage& transforms, RenderKey key, CellsOf cellsOf)
+{
+    for (auto iter = list.begin(); iter != list.end(); ++iter) {
+        const auto& transformId = iter->transformId;
+        if (!transforms.valid(transformId)) {
+            continue;
+        }
+
+        auto index = iter.getGenerationIndex();
+        if (index.index >= placements.size()) {
+            placements.resize(index.index + 1);
+        }
+
+        auto& placement = placements[index.index];
+        const auto& chunk = transforms.chunk(transformId.index / TransformStorage::chunkSize);
+        size_t slot = transformId.index % TransformStorage::chunkSize;
+        glm::vec2 offset;
+        glm::ivec2 size;
+        shapeOf(*iter, offset, size);
+        if (!placement.dirty && placement.position == chunk.positions[slot] && placement.previousPosition == chunk.previousPositions[slot]
+            && placement.scale == chunk.scales[slot] && placement.rotation == chunk.rotations[slot] && placement.offset == offset && placement.size == size) {
+            continue;
+        }
+
+        placement.position = chunk.positions[slot];
+        placement.previousPosition = chunk.previousPositions[slot];
+        placement.scale = chunk.scales[slot];
+        placement.rotation = chunk.rotations[slot];
+        placement.offset = offset;
+        placement.size = size;
+        placement.dirty = false;
+
+        auto range = cellsOf(*iter, placement);
+        if (range != placement.cells) {
+            key.entry = index;
+            grid.move(key, placement.cells, range);
+            placement.cells = range;
+        }
+    }
+}
+
+// A sprite found in the grid, ready to draw if it really is inside the camera rect
+static bool makeDrawItem(const Sprite& sprite, const glm::vec2& position, const Transform2DRef& transform, const glm::vec2& cameraMin, const glm::vec2& cameraMax, DrawItem& item)
+{
+    glm::vec2 center, halfSize;
+    spriteBounds(sprite, position, transform.scale, transform.rotation, center, halfSize);
+    if (center.x + halfSize.x < cameraMin.x || center.y + halfSize.y < cameraMin.y || center.x - halfSize.x > cameraMax.x || center.y - halfSize.y > cameraMax.y) {
+        return false;
+    }
+
+    item.destination.x = roundf(position.x + sprite.offset.x - cameraMin.x);
+    item.destination.y = roundf(position.y + sprite.offset.y - cameraMin.y);
+    item.destination.w = roundf(transform.scale.x * static_cast<float>(sprite.source.w));
+    item.destination.h = roundf(transform.scale.y * static_cast<float>(sprite.source.h));
+    item.rotation = transform.rotation;
+    item.source = { sprite.source.x, sprite.source.y, sprite.source.w, sprite.source.h };
+    item.flip = static_cast<SDL_RendererFlip>((transform.flipHorizontal ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE) | (transform.flipVertical ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE));
+    return true;
 }
 
 void RenderSystem::update(double dt)
 {
+    // simulation only
+    if (Window::headless) {
+        return;
+    }
+
+    // only what moved or was handed out since the last frame changes cells
+    auto& transforms = TransformSystem::instance->getStorage();
+    auto& grid = data->grid;
+    for (auto&& layerIndex : data->activeLayers) {
+        for (auto&& entry : data->layers[layerIndex]) {
+            RenderKey key;
+            key.layer = layerIndex;
+            key.texture = entry.texture;
+            key.batch = false;
+            refreshPlacements(grid, entry.sprites, entry.spritePlacements, transforms, key, [&grid](const Sprite& sprite, const GridPlacement& placement) {
+                glm::vec2 center, halfSize, previousCenter;
+                spriteBounds(sprite, placement.previousPosition, placement.scale, placement.rotation, previousCenter, halfSize);
+                spriteBounds(sprite, placement.position, placement.scale, placement.rotation, center, halfSize);
+                return boundsCells(grid, glm::min(center, previousCenter) - halfSize, glm::max(center, previousCenter) + halfSize);
+            });
+
+            // tilemaps and the like never move, after their first frame they are one compare each
+            key.batch = true;
+            refreshPlacements(grid, entry.batches, entry.batchPlacements, transforms, key, [&grid](const SpriteBatch& batch, const GridPlacement& placement) {
+                const auto& boundary = batch.boundary;
+                // no boundary, no culling
+                if (boundary.w <= 0 && boundary.h <= 0) {
+                    return RenderGrid::everywhere();
+                }
+                glm::vec2 min = glm::min(placement.position, placement.previousPosition) + glm::vec2(boundary.x, boundary.y);
+                glm::vec2 max = glm::max(placement.position, placement.previousPosition) + glm::vec2(boundary.x + boundary.w, boundary.y + boundary.h);
+                return boundsCells(grid, min, max);
+            });
+        }
+    }
+
     SDL_Rect fullViewport;
     SDL_RenderGetViewport(Window::renderer, &fullViewport);
     // for each camera
@@ -313,7 +728,7 @@ void RenderSystem::update(double dt)
             viewport = fullViewport;
         }
         SDL_RenderSetViewport(Window::renderer, &viewport);
-        glm::vec2 cameraOffset = TransformSystem::instance->get(camera.transformId).position + camera.offset;
+        glm::vec2 cameraOffset = TransformSystem::instance->getInterpolatedPosition(camera.transformId) + camera.offset;
         Rect cameraWorldRect(glm::ivec2(cameraOffset), glm::ivec2(viewport.w, viewport.h));
 
         // centerd camera?
@@ -321,44 +736,127 @@ void RenderSystem::update(double dt)
             cameraOffset -= glm::vec2(cameraWorldRect.size()) * 0.5f;
             cameraWorldRect -= glm::ivec2(glm::vec2(cameraWorldRect.size()) * 0.5f);
         }
+        glm::vec2 cameraMax = cameraOffset + glm::vec2(viewport.w, viewport.h);
+
+        // only what is close by, already in draw order
+        auto& visible = data->visible;
+        visible.clear();
+        grid.query(grid.cellsOf(cameraOffset, cameraMax), visible);
+
+        // one layer and texture at a time
+        for (size_t first = 0; first < visible.size();) {
+            size_t last = first;
+            while (last < visible.size() && visible[last].layer == visible[first].layer && visible[last].texture == visible[first].texture) {
+                last++;
+            }
 
-        // for each layer
-        for (auto&& layer : data->layers) {
-            // for each type of texture
-            for (auto&& texture : layer) {
-                auto& tex = data->textures[texture.first];
-                // render single sprites
-                for (auto&& sprite : texture.second->sprites) {
-                    const auto& transform = TransformSystem::instance->get(sprite.transformId);
-                    drawOne(cameraOffset, tex, transform, sprite.offset, sprite.source, transform.flipHorizontal, transform.flipVertical);
+            auto entryPtr = data->findEntry(visible[first].layer, visible[first].texture);
+            auto textureIter = data->textures.find(visible[first].texture);
+            if (!entryPtr || textureIter == data->textures.end()) {
+                first = last;
+                continue;
+            }
+            auto& entry = *entryPtr;
+            auto& tex = *textureIter;
+
+            // single sprites, culled first so the draw loop only sees visible ones
+            auto& drawItems = data->drawItems;
+            drawItems.clear();
+            size_t key = first;
+            for (; key < last && !visible[key].batch; key++) {
+                auto spriteIter = entry.sprites.find(visible[key].entry);
+                if (spriteIter == entry.sprites.end() || !transforms.valid(spriteIter->transformId)) {
+                    continue;
+                }
+                const auto& sprite = *spriteIter;
+                DrawItem item;
+                if (makeDrawItem(sprite, TransformSystem::instance->getInterpolatedPosition(sprite.transformId), transforms.get(sprite.transformId), cameraOffset, cameraMax, item)) {
+                    drawItems.push_back(item);
+                }
+            }
+            auto textureId = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(tex.rawData.hwData));
+            if (data->glBackend) {
+                data->glSprites.add(textureId, tex.rawData.width, tex.rawData.height, tex.format, viewport, drawItems.data(), drawItems.size());
+            } else {
+                for (auto&& item : drawItems) {
+                    SDL_RenderCopyExF(Window::renderer, tex.tex, &item.source, &item.destination, item.rotation, nullptr, item.flip);
                 }
+            }
 
-                // render batches
-                for (auto&& batch : texture.second->batches) {
-                    const auto& transform = TransformSystem::instance->get(batch.transformId);
-                    // naive view frustim culling
-                    if (batch.boundary.w > 0 || batch.boundary.h > 0) {
-                        auto brect = batch.boundary;
-                        brect += glm::ivec2(transform.position);
-                        if (!cameraWorldRect.intersect(brect)) {
-                            continue;
-                        }
+            // batches, baked once and then only moved around
+            for (; key < last; key++) {
+                auto batchIter = entry.batches.find(visible[key].entry);
+                if (batchIter == entry.batches.end() || !transforms.valid(batchIter->transformId)) {
+                    continue;
+                }
+                const auto& batch = *batchIter;
+                const auto& transform = transforms.get(batch.transformId);
+                glm::vec2 position = TransformSystem::instance->getInterpolatedPosition(batch.transformId);
+                // the grid is per cell, this is the exact test
+                if (batch.boundary.w > 0 || batch.boundary.h > 0) {
+                    auto brect = batch.boundary;
+                    brect += glm::ivec2(position);
+                    if (!cameraWorldRect.intersect(brect)) {
+                        continue;
                     }
-                    for (auto&& single : batch.batch) {
-                        drawOne(cameraOffset, tex, transform, single.pos, single.src, single.hFlip, single.vFlip);
+                }
+
+                auto& cache = batchCache(*data, entry, visible[key].entry.index, batch, transform);
+                // the batch moves by whole pixels, its sprites are rounded already
+                glm::vec2 offset = glm::round(position - cameraOffset);
+                if (data->glBackend) {
+                    if (!cache.buffer) {
+                        cache.buffer = data->glSprites.bake(tex.rawData.width, tex.rawData.height, cache.items.data(), cache.items.size());
+                    }
+                    data->glSprites.addBaked(cache.buffer, cache.items.size(), textureId, tex.format, viewport, offset.x, offset.y);
+                } else {
+                    for (auto item : cache.items) {
+                        item.destination.x += offset.x;
+                        item.destination.y += offset.y;
+                        SDL_RenderCopyExF(Window::renderer, tex.tex, &item.source, &item.destination, item.rotation, nullptr, item.flip);
                     }
                 }
             }
+
+            first = last;
         }
 
         if (!camera.fillTarget) {
         }
     }
 
+    // everything the cameras found, one upload
+    if (data->glBackend) {
+        data->glSprites.flush();
+    }
+
     SDL_RenderSetViewport(Window::renderer, &fullViewport);
     glm::vec2 cameraOffset = glm::vec2(0.0);
 }
 
+bool RenderSystem::setGLBackend(bool enabled)
+{
+    if (!enabled) {
+        data->glBackend = false;
+        data->releaseBaked();
+        data->glSprites.release();
+        return true;
+    }
+
+    if (!data->glSprites.ready() && !data->glSprites.init(Window::renderer)) {
+        SDL_Log("Drawing sprites with SDL after all");
+        data->glBackend = false;
+        return false;
+    }
+    data->glBackend = true;
+    return true;
+}
+
+bool RenderSystem::usingGLBackend() const
+{
+    return data->glBackend;
+}
+
 const RawTextureData& RenderSystem::getSpriteTextureData(IndexType i)
 {
     static RawTextureData dummy;
@@ -15,6 +15,7 @@
 #ifndef _systems_sprite_h
 #define _systems_sprite_h
 
+#include "systems/schedule.h"
 #include "systems/transform.h"
 #include "util/rect.h"
 #include <cstdint>
@@ -60,19 +61,41 @@ public:
     };
     using IndexType = SlotMap<UniqueSpriteIndex>::IndexType;
     using BatchIndexType = SlotMap<UniqueBatchIndex>::IndexType;
+    using TextureIndexType = SlotMapIndex;
 
     RenderSystem();
     ~RenderSystem();
 
+    // Loads the file on first use, after that its a lookup. false if the file cant be loaded.
+    // The texture lives as long as sprites, batches or retains use it.
+    bool loadTexture(const std::string& filename, TextureIndexType& texture);
+    // for things that hold on to a texture id without having a sprite (prefabs)
+    void retainTexture(const TextureIndexType& texture);
+    void releaseTexture(const TextureIndexType& texture);
+
     IndexType createSprite(const TransformComponent& transformComponent, const std::string& filename, uint8_t layer);
     IndexType createSprite(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer);
+    // no filename lookup, for spawning lots of the same
+    IndexType createSprite(const TransformSystem::IndexType& transformId, const TextureIndexType& texture, uint8_t layer);
     Sprite& getSprite(const IndexType& i);
     void removeSprite(const IndexType& i);
+    void removeSprites(const std::vector<IndexType>& indices);
 
     BatchIndexType createBatch(const TransformSystem::IndexType& transformId, const std::string& filename, uint8_t layer, const std::vector<BatchSprite>& inBatch);
     SpriteBatch& getBatch(const BatchIndexType& i);
     void removeBatch(const BatchIndexType& i);
+    void removeBatches(const std::vector<BatchIndexType>& indices);
+
+    // give back memory after a lot of removals (map unload etc). indices stay valid
+    void shrinkToFit();
+
+    // Sprites through the gl sprite renderer instead of SDL_RenderCopyEx, one draw call per layer and texture.
+    // false if that does not work with the current renderer, then SDL keeps drawing
+    bool setGLBackend(bool enabled);
+    bool usingGLBackend() const;
 
+    // sdl
+    static constexpr SystemAccess access = { StoreTransform | StoreSprite | StoreCamera, 0, true };
     void update(double dt);
 
     const RawTextureData& getSpriteTextureData(IndexType i);
@@ -17,7 +17,36 @@
 
 SpriteComponent::~SpriteComponent()
 {
-    RenderSystem::instance->removeSprite(index);
+    if (owning) {
+        RenderSystem::instance->removeSprite(index);
+    }
+}
+
+ComponentTypeId SpriteComponent::staticTypeId()
+{
+    static const ComponentTypeId id = registerComponentType(
+        [](uint64_t rawIndex) {
+            RenderSystem::instance->removeSprite(IndexType(rawIndex));
+        },
+        [](const uint64_t* rawIndices, size_t count) {
+            RenderSystem::instance->removeSprites(std::vector<IndexType>(rawIndices, rawIndices + count));
+        });
+    return id;
+}
+
+ComponentTypeId SpriteComponent::typeId() const
+{
+    return staticTypeId();
+}
+
+bool SpriteComponent::release(uint64_t& rawIndex)
+{
+    if (!owning) {
+        return false;
+    }
+    owning = false;
+    rawIndex = index.toInt();
+    return true;
 }
 
 Sprite& SpriteComponent::get()
@@ -25,6 +54,11 @@ Sprite& SpriteComponent::get()
     return RenderSystem::instance->getSprite(index);
 }
 
+uint64_t SpriteComponent::getRawIndex() const
+{
+    return index.toInt();
+}
+
 SpriteComponent::IndexType SpriteComponent::getIndex() const
 {
     return index;
@@ -44,7 +78,36 @@ PyType<SpriteComponent, PySpriteComponent, ComponentWrapperBase, Sprite> pysprit
 
 SpriteBatchComponent::~SpriteBatchComponent()
 {
-    RenderSystem::instance->removeSprite(index);
+    if (owning) {
+        RenderSystem::instance->removeBatch(index);
+    }
+}
+
+ComponentTypeId SpriteBatchComponent::staticTypeId()
+{
+    static const ComponentTypeId id = registerComponentType(
+        [](uint64_t rawIndex) {
+            RenderSystem::instance->removeBatch(IndexType(rawIndex));
+        },
+        [](const uint64_t* rawIndices, size_t count) {
+            RenderSystem::instance->removeBatches(std::vector<IndexType>(rawIndices, rawIndices + count));
+        });
+    return id;
+}
+
+ComponentTypeId SpriteBatchComponent::typeId() const
+{
+    return staticTypeId();
+}
+
+bool SpriteBatchComponent::release(uint64_t& rawIndex)
+{
+    if (!owning) {
+        return false;
+    }
+    owning = false;
+    rawIndex = index.toInt();
+    return true;
 }
 
 SpriteBatch& SpriteBatchComponent::get()
@@ -52,6 +115,11 @@ SpriteBatch& SpriteBatchComponent::get()
     return RenderSystem::instance->getBatch(index);
 }
 
+uint64_t SpriteBatchComponent::getRawIndex() const
+{
+    return index.toInt();
+}
+
 SpriteBatchComponent::IndexType SpriteBatchComponent::getIndex() const
 {
     return index;
@@ -27,10 +27,15 @@ public:
     SpriteComponent(Args&&... args)
     {
         index = RenderSystem::instance->createSprite(std::forward<Args>(args)...);
-        valid = true;
+        owning = true;
     }
     ~SpriteComponent();
 
+    static ComponentTypeId staticTypeId();
+    ComponentTypeId typeId() const override;
+    bool release(uint64_t& rawIndex) override;
+    uint64_t getRawIndex() const override;
+
     SpriteComponent(SpriteComponent&& other) = delete;
     SpriteComponent(const SpriteComponent& other) = delete;
 
@@ -40,7 +45,7 @@ public:
 
 private:
     IndexType index;
-    bool valid;
+    bool owning;
 };
 
 class SpriteBatchComponent : public ComponentWrapperBase {
@@ -53,10 +58,15 @@ public:
     SpriteBatchComponent(Args&&... args)
     {
         index = RenderSystem::instance->createBatch(std::forward<Args>(args)...);
-        valid = true;
+        owning = true;
     }
     ~SpriteBatchComponent();
 
+    static ComponentTypeId staticTypeId();
+    ComponentTypeId typeId() const override;
+    bool release(uint64_t& rawIndex) override;
+    uint64_t getRawIndex() const override;
+
     SpriteBatchComponent(SpriteComponent&& other) = delete;
     SpriteBatchComponent(const SpriteComponent& other) = delete;
 
@@ -66,7 +76,7 @@ public:
 
 private:
     IndexType index;
-    bool valid;
+    bool owning;
 };
 
 #endif //_systems_rendercomponents_h
\ No newline at end of file
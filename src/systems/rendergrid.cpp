@@ -0,0 +1,170 @@
+/*
+    rendergrid.cpp: uniform grid over everything the render system draws
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "rendergrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+bool RenderKey::operator<(const RenderKey& other) const
+{
+    return std::make_tuple(layer, texture.index, texture.generation, batch, entry.index, entry.generation)
+        < std::make_tuple(other.layer, other.texture.index, other.texture.generation, other.batch, other.entry.index, other.entry.generation);
+}
+
+bool RenderKey::operator==(const RenderKey& other) const
+{
+    return layer == other.layer && batch == other.batch && texture == other.texture && entry == other.entry;
+}
+
+bool RenderGrid::CellRange::empty() const
+{
+    return !everywhere && (x1 < x0 || y1 < y0);
+}
+
+bool RenderGrid::CellRange::operator==(const CellRange& other) const
+{
+    return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1 && everywhere == other.everywhere;
+}
+
+bool RenderGrid::CellRange::operator!=(const CellRange& other) const
+{
+    return !(*this == other);
+}
+
+RenderGrid::RenderGrid(float cellSize)
+    : cellSize(cellSize)
+{
+}
+
+// far enough out that nothing real gets there, small enough that widths and +1 still fit in an int32
+static const double maxCell = 1 << 29;
+
+static int32_t toCell(float v, float cellSize)
+{
+    double cell = std::floor(static_cast<double>(v) / cellSize);
+    return static_cast<int32_t>(std::min(std::max(cell, -maxCell), maxCell));
+}
+
+RenderGrid::CellRange RenderGrid::cellsOf(const glm::vec2& min, const glm::vec2& max) const
+{
+    // nan and inf would be undefined as an int, and dont say where something is anyway
+    if (!std::isfinite(min.x) || !std::isfinite(min.y) || !std::isfinite(max.x) || !std::isfinite(max.y)) {
+        return everywhere();
+    }
+
+    CellRange range;
+    range.x0 = toCell(min.x, cellSize);
+    range.y0 = toCell(min.y, cellSize);
+    range.x1 = toCell(max.x, cellSize);
+    range.y1 = toCell(max.y, cellSize);
+    return range;
+}
+
+RenderGrid::CellRange RenderGrid::everywhere()
+{
+    CellRange range;
+    range.everywhere = true;
+    return range;
+}
+
+void RenderGrid::insert(const RenderKey& key, const CellRange& range)
+{
+    if (range.everywhere) {
+        unbounded.push_back(key);
+        return;
+    }
+
+    for (int32_t y = range.y0; y <= range.y1; y++) {
+        for (int32_t x = range.x0; x <= range.x1; x++) {
+            cells[cellKey(x, y)].push_back(key);
+        }
+    }
+}
+
+// swap and pop, the order within a cell does not matter
+static void eraseKey(std::vector<RenderKey>& keys, const RenderKey& key)
+{
+    auto iter = std::find(keys.begin(), keys.end(), key);
+    if (iter != keys.end()) {
+        *iter = keys.back();
+        keys.pop_back();
+    }
+}
+
+void RenderGrid::remove(const RenderKey& key, const CellRange& range)
+{
+    if (range.everywhere) {
+        eraseKey(unbounded, key);
+        return;
+    }
+
+    for (int32_t y = range.y0; y <= range.y1; y++) {
+        for (int32_t x = range.x0; x <= range.x1; x++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            eraseKey(cell->second, key);
+            // so the map only ever holds cells something is in
+            if (cell->second.empty()) {
+                cells.erase(cell);
+            }
+        }
+    }
+}
+
+void RenderGrid::move(const RenderKey& key, const CellRange& from, const CellRange& to)
+{
+    remove(key, from);
+    insert(key, to);
+}
+
+void RenderGrid::query(const CellRange& range, std::vector<RenderKey>& result) const
+{
+    result.insert(result.end(), unbounded.begin(), unbounded.end());
+    if (range.everywhere) {
+        for (auto&& cell : cells) {
+            result.insert(result.end(), cell.second.begin(), cell.second.end());
+        }
+    } else if (!range.empty() && static_cast<int64_t>(range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1) > static_cast<int64_t>(cells.size())) {
+        // zoomed out a lot: fewer cells in use than in the range, so go through those instead
+        for (auto&& cell : cells) {
+            int32_t x = static_cast<int32_t>(static_cast<uint32_t>(cell.first));
+            int32_t y = static_cast<int32_t>(cell.first >> 32);
+            if (x >= range.x0 && x <= range.x1 && y >= range.y0 && y <= range.y1) {
+                result.insert(result.end(), cell.second.begin(), cell.second.end());
+            }
+        }
+    } else {
+        for (int32_t y = range.y0; y <= range.y1; y++) {
+            for (int32_t x = range.x0; x <= range.x1; x++) {
+                auto cell = cells.find(cellKey(x, y));
+                if (cell != cells.end()) {
+                    result.insert(result.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+
+    // bigger things are in more than one cell
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+int64_t RenderGrid::cellKey(int32_t x, int32_t y)
+{
+    return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32) | static_cast<uint32_t>(x));
+}
@@ -0,0 +1,76 @@
+/*
+    rendergrid.h: uniform grid over everything the render system draws
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_rendergrid_h
+#define _systems_rendergrid_h
+
+#include "util/slotmap.h"
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <unordered_map>
+#include <vector>
+
+// a sprite or batch, in the order things get drawn: layer, texture, sprites before batches, slot
+struct RenderKey {
+    uint8_t layer = 0;
+    bool batch = false;
+    SlotMapIndex texture;
+    SlotMapIndex entry;
+
+    bool operator<(const RenderKey& other) const;
+    bool operator==(const RenderKey& other) const;
+};
+
+// Uniform grid over world space, so cameras only look at what is close to them.
+// Everything is in all the cells its bounds overlap. The render system only works out the bounds again
+// for things that moved or were handed out, and only things that end up in other cells touch the grid.
+class RenderGrid {
+public:
+    // inclusive cell coordinates. the default one is in no cell at all
+    struct CellRange {
+        int32_t x0 = 0;
+        int32_t y0 = 0;
+        int32_t x1 = -1;
+        int32_t y1 = -1;
+        // for things without bounds, they are always visible
+        bool everywhere = false;
+
+        bool empty() const;
+        bool operator==(const CellRange& other) const;
+        bool operator!=(const CellRange& other) const;
+    };
+
+    explicit RenderGrid(float cellSize = 256.0f);
+
+    CellRange cellsOf(const glm::vec2& min, const glm::vec2& max) const;
+    static CellRange everywhere();
+
+    void insert(const RenderKey& key, const CellRange& cells);
+    void remove(const RenderKey& key, const CellRange& cells);
+    void move(const RenderKey& key, const CellRange& from, const CellRange& to);
+
+    // everything in these cells, plus the ones that are everywhere. sorted in draw order, no duplicates.
+    // everywhere() as the cells gives everything
+    void query(const CellRange& cells, std::vector<RenderKey>& result) const;
+
+private:
+    static int64_t cellKey(int32_t x, int32_t y);
+
+    float cellSize;
+    std::unordered_map<int64_t, std::vector<RenderKey>> cells;
+    std::vector<RenderKey> unbounded;
+};
+
+#endif // _systems_rendergrid_h
@@ -0,0 +1,165 @@
+/*
+    schedule.cpp: derives the system update order from what the systems touch
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "schedule.h"
+#include "runtime/jobs.h"
+#include "runtime/profiler.h"
+
+#include "SDL.h"
+
+static std::string storeNames(uint32_t stores)
+{
+    static const char* names[] = {
+        "Transform2D",
+        "Collider",
+        "Sprite",
+        "SimplePhysicsObject",
+        "Animation",
+        "Tilemap",
+        "Camera",
+        "Input",
+        "Tick",
+        "Entity"
+    };
+
+    if (stores == StoreAll) {
+        return "everything";
+    }
+
+    std::string result;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (stores & (1u << i)) {
+            if (!result.empty()) {
+                result += ", ";
+            }
+            result += names[i];
+        }
+    }
+    return result;
+}
+
+void SystemSchedule::add(const std::string& name, const SystemAccess& access, SystemPhase phase, Update update)
+{
+    Entry entry;
+    entry.name = name;
+    entry.zone = Profiler::zoneId(name.c_str());
+    entry.access = access;
+    entry.phase = phase;
+    entry.update = update;
+    entries.push_back(entry);
+}
+
+void SystemSchedule::build()
+{
+    // reachable[i][j]: i runs after j, directly or through others
+    std::vector<std::vector<bool>> reachable(entries.size(), std::vector<bool>(entries.size(), false));
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto& entry = entries[i];
+        const auto& a = entry.access;
+        entry.dependencies.clear();
+
+        // latest first, so anything already covered by a later dependency can be skipped
+        for (size_t j = i; j-- > 0;) {
+            // phases run one after another anyway
+            if (entries[j].phase != entry.phase) {
+                continue;
+            }
+
+            const auto& b = entries[j].access;
+            bool conflict = (a.writes & (b.reads | b.writes)) || (a.reads & b.writes);
+            // main thread systems keep their order between each other
+            bool bothMain = a.mainThread && b.mainThread;
+            if (!conflict && !bothMain) {
+                continue;
+            }
+
+            // two systems that could run anywhere both write the same thing.
+            // they still work (the earlier one goes first), but someone should know
+            uint32_t bothWrite = a.writes & b.writes;
+            if (bothWrite && !a.mainThread && !b.mainThread) {
+                SDL_Log("Schedule: %s and %s both write %s, %s runs first",
+                    entries[j].name.c_str(),
+                    entry.name.c_str(),
+                    storeNames(bothWrite).c_str(),
+                    entries[j].name.c_str());
+            }
+
+            if (reachable[i][j]) {
+                continue;
+            }
+
+            entry.dependencies.push_back(j);
+            reachable[i][j] = true;
+            for (size_t k = 0; k < j; k++) {
+                if (reachable[j][k]) {
+                    reachable[i][k] = true;
+                }
+            }
+        }
+    }
+
+    SDL_Log("Schedule:\n%s", describe().c_str());
+}
+
+void SystemSchedule::run(JobSystem& jobs, double dt, SystemPhase phase)
+{
+    // one per entry, the ones of other phases stay empty (empty handles count as done)
+    std::vector<JobHandle> handles;
+    handles.reserve(entries.size());
+
+    for (auto&& entry : entries) {
+        if (entry.phase != phase) {
+            handles.emplace_back();
+            continue;
+        }
+
+        std::vector<JobHandle> dependencies;
+        for (auto&& dependency : entry.dependencies) {
+            dependencies.push_back(handles[dependency]);
+        }
+
+        auto affinity = entry.access.mainThread ? JobAffinity::Main : JobAffinity::Any;
+        const Update* update = &entry.update;
+        // entries dont change after setup, so the name stays valid for the profiler
+        const char* name = entry.name.c_str();
+        uint32_t zone = entry.zone;
+        handles.push_back(jobs.after(dependencies, [update, zone, name, dt]() {
+            ProfileScope scope(zone, name);
+            (*update)(dt);
+        },
+            affinity));
+    }
+
+    jobs.wait(handles);
+}
+
+std::string SystemSchedule::describe() const
+{
+    std::string result;
+    static const char* phaseNames[] = { "early", "fixed", "late" };
+    for (auto&& entry : entries) {
+        result += "    " + entry.name;
+        result += std::string(" [") + phaseNames[static_cast<int>(entry.phase)] + "]";
+        result += entry.access.mainThread ? " (main thread)" : "";
+        if (!entry.dependencies.empty()) {
+            result += " after";
+            for (auto&& dependency : entry.dependencies) {
+                result += " " + entries[dependency].name;
+            }
+        }
+        result += "\n";
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+    schedule.h: derives the system update order from what the systems touch
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_schedule_h
+#define _systems_schedule_h
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// the component stores, as bits
+enum ComponentStore : uint32_t {
+    StoreTransform = 1 << 0,
+    StoreCollider = 1 << 1,
+    StoreSprite = 1 << 2,
+    StorePhysics = 1 << 3,
+    StoreAnimation = 1 << 4,
+    StoreTilemap = 1 << 5,
+    StoreCamera = 1 << 6,
+    StoreInput = 1 << 7,
+    StoreTick = 1 << 8,
+    StoreEntity = 1 << 9,
+    // python can get at everything
+    StoreAll = 0xFFFFFFFF
+};
+
+// What a system touches during update. Every system has a static one of these.
+struct SystemAccess {
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    // sdl or python in there
+    bool mainThread = false;
+};
+
+// When in the frame a system runs
+enum class SystemPhase {
+    Early, // once per frame, before the simulation (input etc)
+    Fixed, // simulation, zero or more times per frame with a fixed dt
+    Late // once per frame, after the simulation (rendering etc)
+};
+// Dependencies only exist within a phase, and so does running at the same time.
+// A system that could overlap the simulation gets nothing out of that in Early or Late.
+
+// Systems are added in their preferred order. A system runs after every earlier one of the same phase it conflicts with
+// (one writes what the other reads or writes), everything else is free to run at the same time.
+class SystemSchedule {
+public:
+    using Update = std::function<void(double)>;
+
+    void add(const std::string& name, const SystemAccess& access, SystemPhase phase, Update update);
+
+    // works out the dependencies. logs write/write conflicts between systems that are not main-thread-bound
+    void build();
+
+    // all systems of one phase. returns when they are done
+    void run(JobSystem& jobs, double dt, SystemPhase phase);
+
+    // readable version of the plan, for the log
+    std::string describe() const;
+
+private:
+    struct Entry {
+        std::string name;
+        // the profiler zone of name
+        uint32_t zone;
+        SystemAccess access;
+        SystemPhase phase;
+        Update update;
+        std::vector<size_t> dependencies;
+    };
+
+    std::vector<Entry> entries;
+};
+
+#endif // _systems_schedule_h
\ No newline at end of file
@@ -14,6 +14,7 @@
 */
 
 #include "simplephysics.h"
+#include "runtime/jobs.h"
 #include <glm/glm.hpp>
 
 std::shared_ptr<SimplePhysicsSystem> SimplePhysicsSystem::instance(nullptr);
@@ -39,7 +40,12 @@ SimplePhysicsSystem::IndexType SimplePhysicsSystem::create(const TransformSystem
 
 SimplePhysicsObject& SimplePhysicsSystem::get(const IndexType& i)
 {
-    return objects[i];
+    // handles can outlive a destroyed entity
+    static SimplePhysicsObject dummy;
+    if (auto iter = objects.find(i); iter != objects.end()) {
+        return *iter;
+    }
+    return dummy;
 }
 
 void SimplePhysicsSystem::remove(const IndexType& i)
@@ -47,21 +53,56 @@ void SimplePhysicsSystem::remove(const IndexType& i)
     objects.remove(i);
 }
 
+void SimplePhysicsSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    objects.removeMany(indices);
+}
+
+static void clampVelocity(SimplePhysicsObject& obj)
+{
+    if (obj.maxVelocity.x > 0.0f && obj.maxVelocity.x < glm::abs(obj.velocity.x)) {
+        obj.velocity.x = obj.maxVelocity.x * ((0.0f < obj.velocity.x) - (obj.velocity.x < 0.0f));
+    }
+    if (obj.maxVelocity.y > 0.0f && obj.maxVelocity.y < glm::abs(obj.velocity.y)) {
+        obj.velocity.y = obj.maxVelocity.y * ((0.0f < obj.velocity.y) - (obj.velocity.y < 0.0f));
+    }
+}
+
 void SimplePhysicsSystem::update(double dt)
 {
+    // objects without collision only ever touch their own transform, so they can go wide.
+    // sorted, so the position writes walk through the transform chunks in order
+    view.build(objects, TransformSystem::instance->getStorage(), true);
+    view.parallelForEach(*JobSystem::instance, [dt](const View<Transform2D, SimplePhysicsObject>::Row& row) {
+        auto& obj = *row.component;
+        if (obj.collision) {
+            return;
+        }
+
+        auto& position = row.position();
+        position += obj.velocity * static_cast<float>(dt);
+        obj.velocity += (obj.gravity + obj.acceleration) * static_cast<float>(dt);
+        clampVelocity(obj);
+    });
+
+    // collision checks look at everyone elses transforms, so these stay in order
     for (auto&& obj : objects) {
-        auto& transform = TransformSystem::instance->get(obj.transformId);
-        glm::vec2 lastPosition = transform.position;
+        if (!obj.collision) {
+            continue;
+        }
+
+        auto& position = TransformSystem::instance->getPosition(obj.transformId);
+        glm::vec2 lastPosition = position;
         glm::vec2 newPosition = lastPosition;
         glm::vec2 lastVelocity = obj.velocity;
         glm::vec2 newVelocity = lastVelocity;
         auto actualAcceleration = obj.gravity + obj.acceleration;
-        bool wasColliding = !obj.collision || CollisionSystem::instance->checkCollision(obj.colliderId);
+        bool wasColliding = CollisionSystem::instance->checkCollision(obj.colliderId);
 
         newPosition += obj.velocity * static_cast<float>(dt);
         newVelocity = obj.velocity + actualAcceleration * static_cast<float>(dt);
 
-        transform.position = newPosition;
+        position = newPosition;
         obj.velocity = newVelocity;
 
         if (!wasColliding) {
@@ -77,7 +118,7 @@ void SimplePhysicsSystem::update(double dt)
                 for (int steps = static_cast<int>(glm::length(dist)); colliding && steps > 0; --steps) {
                     postCollisionVelocity = glm::normalize(lastVelocity) * static_cast<float>(steps);
                     processedNewPosition = lastPosition + lastVelocity * static_cast<float>(dt);
-                    transform.position = processedNewPosition;
+                    position = processedNewPosition;
                     // check if we are still colliding
                     colliding = CollisionSystem::instance->checkCollision(obj.colliderId);
                 }
@@ -92,14 +133,14 @@ void SimplePhysicsSystem::update(double dt)
                     float tmp = postCollisionVelocity.y;
                     postCollisionVelocity.y = 0.0f;
                     glm::vec2 xAxisPos = processedNewPosition + postCollisionVelocity * static_cast<float>(dt);
-                    transform.position = xAxisPos;
+                    position = xAxisPos;
                     colliding = CollisionSystem::instance->checkCollision(obj.colliderId);
                     if (colliding) {
                         // try y axis movement
                         postCollisionVelocity.y = tmp;
                         postCollisionVelocity.x = 0.0f;
                         glm::vec2 yAxisPos = processedNewPosition + postCollisionVelocity * static_cast<float>(dt);
-                        transform.position = yAxisPos;
+                        position = yAxisPos;
                         colliding = CollisionSystem::instance->checkCollision(obj.colliderId);
                         if (colliding) {
                             // rip any movememnt
@@ -113,16 +154,11 @@ void SimplePhysicsSystem::update(double dt)
                     }
                 }
 
-                transform.position = processedNewPosition;
+                position = processedNewPosition;
                 obj.velocity = postCollisionVelocity + obj.acceleration * static_cast<float>(dt);
             }
         }
-        if (obj.maxVelocity.x > 0.0f && obj.maxVelocity.x < glm::abs(obj.velocity.x)) {
-            obj.velocity.x = obj.maxVelocity.x * ((0.0f < obj.velocity.x) - (obj.velocity.x < 0.0f));
-        }
-        if (obj.maxVelocity.y > 0.0f && obj.maxVelocity.y < glm::abs(obj.velocity.y)) {
-            obj.velocity.y = obj.maxVelocity.y * ((0.0f < obj.velocity.y) - (obj.velocity.y < 0.0f));
-        }
+        clampVelocity(obj);
     }
 }
 
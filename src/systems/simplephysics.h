@@ -16,8 +16,11 @@
 #define _systems_simplephysics
 
 #include "component.h"
+#include "schedule.h"
 #include "transform.h"
 #include "collision.h"
+#include "view.h"
+#include "util/slotmap.h"
 
 struct SimplePhysicsObject {
     TransformSystem::IndexType transformId = TransformSystem::IndexType();
@@ -39,13 +42,17 @@ public:
     IndexType create(const TransformSystem::IndexType& transformId, CollisionSystem::IndexType& colliderId = CollisionSystem::IndexType(), bool collision = false);
     SimplePhysicsObject& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
 
+    static constexpr SystemAccess access = { StoreCollider | StoreTransform | StorePhysics, StoreTransform | StorePhysics, false };
     void update(double dt);
 
     static std::shared_ptr<SimplePhysicsSystem> instance;
 
 private:
+    // chunked, python holds on to objects from get
     SlotMap<SimplePhysicsObject> objects;
+    View<Transform2D, SimplePhysicsObject> view;
 };
 
 using SimplePhysicsComponent = ComponentWrapper<SimplePhysicsSystem>;
@@ -0,0 +1,433 @@
+/*
+    spriterenderer.cpp: sprites drawn with plain gles2
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "spriterenderer.h"
+
+#include <GL/gl3w.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <string>
+
+static const char* vertexSource = R"(#version 100
+attribute vec2 position;
+attribute vec2 texCoord;
+// scale and offset from viewport pixels to clip space
+uniform vec4 transform;
+varying vec2 uv;
+void main()
+{
+    uv = texCoord;
+    gl_Position = vec4(position * transform.xy + transform.zw, 0.0, 1.0);
+}
+)";
+
+static const char* fragmentSource = R"(#version 100
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+uniform sampler2D image;
+// x: swap red and blue, y: ignore alpha
+uniform vec2 swizzle;
+varying vec2 uv;
+void main()
+{
+    vec4 color = texture2D(image, uv);
+    color = mix(color, color.bgra, swizzle.x);
+    color.a = mix(color.a, 1.0, swizzle.y);
+    gl_FragColor = color;
+}
+)";
+
+static const GLuint positionAttribute = 0;
+static const GLuint texCoordAttribute = 1;
+
+GLSpriteRenderer::~GLSpriteRenderer()
+{
+    release();
+}
+
+bool GLSpriteRenderer::init(SDL_Renderer* sdlRenderer)
+{
+    release();
+
+    SDL_RendererInfo info;
+    if (!sdlRenderer || SDL_GetRendererInfo(sdlRenderer, &info) != 0) {
+        SDL_Log("No renderer to draw sprites with");
+        return false;
+    }
+    std::string name = info.name;
+    if (name != "opengles2" && name != "opengl") {
+        SDL_Log("Cannot draw sprites with gl on top of the %s renderer", info.name);
+        return false;
+    }
+    renderer = sdlRenderer;
+    swizzleTextures = name == "opengles2";
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vertexShader || !fragmentShader) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        release();
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glBindAttribLocation(program, positionAttribute, "position");
+    glBindAttribLocation(program, texCoordAttribute, "texCoord");
+    glLinkProgram(program);
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        SDL_Log("Cannot link the sprite shader: %s", log);
+        release();
+        return false;
+    }
+    transformLocation = glGetUniformLocation(program, "transform");
+    swizzleLocation = glGetUniformLocation(program, "swizzle");
+    imageLocation = glGetUniformLocation(program, "image");
+
+    // every quad uses the same six indices, so this never changes
+    std::vector<uint16_t> indices(maxQuads * 6);
+    for (uint32_t quad = 0; quad < maxQuads; quad++) {
+        uint16_t first = static_cast<uint16_t>(quad * 4);
+        uint16_t* out = &indices[quad * 6];
+        out[0] = first;
+        out[1] = first + 1;
+        out[2] = first + 2;
+        out[3] = first + 2;
+        out[4] = first + 3;
+        out[5] = first;
+    }
+
+    // SDL keeps track of its buffer bindings
+    GLint lastArrayBuffer = 0;
+    GLint lastElementBuffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &lastElementBuffer);
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(lastArrayBuffer));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLuint>(lastElementBuffer));
+
+    return true;
+}
+
+void GLSpriteRenderer::release()
+{
+    if (program) {
+        glDeleteProgram(program);
+    }
+    if (vertexBuffer) {
+        glDeleteBuffers(1, &vertexBuffer);
+    }
+    if (indexBuffer) {
+        glDeleteBuffers(1, &indexBuffer);
+    }
+    program = 0;
+    vertexBuffer = 0;
+    indexBuffer = 0;
+    renderer = nullptr;
+    vertices.clear();
+    calls.clear();
+}
+
+bool GLSpriteRenderer::ready() const
+{
+    return program != 0;
+}
+
+void GLSpriteRenderer::add(uint32_t texture, uint32_t width, uint32_t height, uint32_t format, const SDL_Rect& viewport, const DrawItem* items, size_t count)
+{
+    if (!count || !width || !height || viewport.w <= 0 || viewport.h <= 0) {
+        return;
+    }
+
+    size_t first = vertices.size();
+    vertices.resize(first + count * 4);
+    writeQuads(items, count, width, height, vertices.data() + first);
+
+    DrawCall call = { texture, viewport, false, false, 0, 0.0f, 0.0f, static_cast<uint32_t>(first), static_cast<uint32_t>(count) };
+    swizzle(format, call);
+    queue(call);
+}
+
+uint32_t GLSpriteRenderer::bake(uint32_t width, uint32_t height, const DrawItem* items, size_t count)
+{
+    if (!ready() || !count || !width || !height) {
+        return 0;
+    }
+
+    bakeVertices.resize(count * 4);
+    writeQuads(items, count, width, height, bakeVertices.data());
+
+    GLint lastArrayBuffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, bakeVertices.size() * sizeof(Vertex), bakeVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(lastArrayBuffer));
+    return buffer;
+}
+
+void GLSpriteRenderer::releaseBaked(uint32_t buffer)
+{
+    if (buffer) {
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+void GLSpriteRenderer::addBaked(uint32_t buffer, size_t quads, uint32_t texture, uint32_t format, const SDL_Rect& viewport, float offsetX, float offsetY)
+{
+    if (!buffer || !quads || viewport.w <= 0 || viewport.h <= 0) {
+        return;
+    }
+
+    DrawCall call = { texture, viewport, false, false, buffer, offsetX, offsetY, 0, static_cast<uint32_t>(quads) };
+    swizzle(format, call);
+    queue(call);
+}
+
+void GLSpriteRenderer::writeQuads(const DrawItem* items, size_t count, uint32_t width, uint32_t height, Vertex* out)
+{
+    float invWidth = 1.0f / static_cast<float>(width);
+    float invHeight = 1.0f / static_cast<float>(height);
+    for (size_t i = 0; i < count; i++, out += 4) {
+        const auto& item = items[i];
+        float u0 = static_cast<float>(item.source.x) * invWidth;
+        float u1 = static_cast<float>(item.source.x + item.source.w) * invWidth;
+        float v0 = static_cast<float>(item.source.y) * invHeight;
+        float v1 = static_cast<float>(item.source.y + item.source.h) * invHeight;
+        if (item.flip & SDL_FLIP_HORIZONTAL) {
+            std::swap(u0, u1);
+        }
+        if (item.flip & SDL_FLIP_VERTICAL) {
+            std::swap(v0, v1);
+        }
+
+        // rotated around the center, clockwise in degrees like SDL does it
+        float halfWidth = item.destination.w * 0.5f;
+        float halfHeight = item.destination.h * 0.5f;
+        float centerX = item.destination.x + halfWidth;
+        float centerY = item.destination.y + halfHeight;
+        float c = 1.0f;
+        float s = 0.0f;
+        if (item.rotation != 0.0) {
+            double radians = glm::radians(item.rotation);
+            c = static_cast<float>(std::cos(radians));
+            s = static_cast<float>(std::sin(radians));
+        }
+        // the two half axes of the quad after rotation
+        float ax = c * halfWidth;
+        float ay = s * halfWidth;
+        float bx = -s * halfHeight;
+        float by = c * halfHeight;
+
+        out[0] = { centerX - ax - bx, centerY - ay - by, u0, v0 };
+        out[1] = { centerX + ax - bx, centerY + ay - by, u1, v0 };
+        out[2] = { centerX + ax + bx, centerY + ay + by, u1, v1 };
+        out[3] = { centerX - ax + bx, centerY - ay + by, u0, v1 };
+    }
+}
+
+void GLSpriteRenderer::swizzle(uint32_t format, DrawCall& call) const
+{
+    if (swizzleTextures) {
+        call.swapRedBlue = format == SDL_PIXELFORMAT_ARGB8888 || format == SDL_PIXELFORMAT_RGB888;
+        call.opaque = format == SDL_PIXELFORMAT_RGB888 || format == SDL_PIXELFORMAT_BGR888;
+    }
+}
+
+void GLSpriteRenderer::queue(DrawCall call)
+{
+    while (call.quads > 0) {
+        uint32_t taken = std::min(call.quads, maxQuads);
+        // groups that can share a draw call do, up to what the index buffer covers
+        if (!calls.empty()) {
+            auto& last = calls.back();
+            bool same = last.texture == call.texture && last.swapRedBlue == call.swapRedBlue && last.opaque == call.opaque
+                && last.buffer == call.buffer && last.offsetX == call.offsetX && last.offsetY == call.offsetY
+                && last.viewport.x == call.viewport.x && last.viewport.y == call.viewport.y && last.viewport.w == call.viewport.w && last.viewport.h == call.viewport.h
+                && last.firstVertex + last.quads * 4 == call.firstVertex;
+            if (same && last.quads < maxQuads) {
+                taken = std::min(call.quads, maxQuads - last.quads);
+                last.quads += taken;
+                call.firstVertex += taken * 4;
+                call.quads -= taken;
+                continue;
+            }
+        }
+
+        DrawCall part = call;
+        part.quads = taken;
+        calls.push_back(part);
+        call.firstVertex += taken * 4;
+        call.quads -= taken;
+    }
+}
+
+void GLSpriteRenderer::flush()
+{
+    lastDrawCalls = calls.size();
+    lastQuads = 0;
+    for (auto&& call : calls) {
+        lastQuads += call.quads;
+    }
+    if (calls.empty() || !ready()) {
+        vertices.clear();
+        calls.clear();
+        return;
+    }
+
+    // whatever SDL has queued goes below the sprites
+    SDL_RenderFlush(renderer);
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+
+    // SDL caches its gl state, so everything touched here goes back to how it was
+    GLint lastProgram, lastArrayBuffer, lastElementBuffer, lastActiveTexture, lastTexture;
+    GLint lastViewport[4];
+    GLint lastBlendSrcRgb, lastBlendDstRgb, lastBlendSrcAlpha, lastBlendDstAlpha;
+    GLint lastPositionEnabled, lastTexCoordEnabled;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &lastProgram);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &lastElementBuffer);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &lastActiveTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+    glGetIntegerv(GL_VIEWPORT, lastViewport);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &lastBlendSrcRgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &lastBlendDstRgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &lastBlendSrcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &lastBlendDstAlpha);
+    glGetVertexAttribiv(positionAttribute, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &lastPositionEnabled);
+    glGetVertexAttribiv(texCoordAttribute, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &lastTexCoordEnabled);
+    GLboolean lastBlend = glIsEnabled(GL_BLEND);
+    GLboolean lastScissor = glIsEnabled(GL_SCISSOR_TEST);
+    GLboolean lastDepth = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean lastCull = glIsEnabled(GL_CULL_FACE);
+
+    glUseProgram(program);
+    glUniform1i(imageLocation, 0);
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    // the one upload for everything that is not baked
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if (!vertices.empty()) {
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
+    }
+    GLuint boundBuffer = vertexBuffer;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glEnableVertexAttribArray(positionAttribute);
+    glEnableVertexAttribArray(texCoordAttribute);
+
+    for (auto&& call : calls) {
+        // gl counts the viewport from the bottom
+        glViewport(call.viewport.x, outputHeight - call.viewport.y - call.viewport.h, call.viewport.w, call.viewport.h);
+        float scaleX = 2.0f / static_cast<float>(call.viewport.w);
+        float scaleY = -2.0f / static_cast<float>(call.viewport.h);
+        glUniform4f(transformLocation, scaleX, scaleY, call.offsetX * scaleX - 1.0f, call.offsetY * scaleY + 1.0f);
+        glUniform2f(swizzleLocation, call.swapRedBlue ? 1.0f : 0.0f, call.opaque ? 1.0f : 0.0f);
+        glBindTexture(GL_TEXTURE_2D, call.texture);
+        GLuint buffer = call.buffer ? call.buffer : vertexBuffer;
+        if (buffer != boundBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            boundBuffer = buffer;
+        }
+
+        // no base vertex in gles2, the attribute pointers move instead
+        size_t offset = call.firstVertex * sizeof(Vertex);
+        glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offset + offsetof(Vertex, x)));
+        glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offset + offsetof(Vertex, u)));
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(call.quads * 6), GL_UNSIGNED_SHORT, nullptr);
+    }
+
+    if (!lastPositionEnabled) {
+        glDisableVertexAttribArray(positionAttribute);
+    }
+    if (!lastTexCoordEnabled) {
+        glDisableVertexAttribArray(texCoordAttribute);
+    }
+    glUseProgram(static_cast<GLuint>(lastProgram));
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(lastTexture));
+    glActiveTexture(static_cast<GLenum>(lastActiveTexture));
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(lastArrayBuffer));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLuint>(lastElementBuffer));
+    glBlendFuncSeparate(lastBlendSrcRgb, lastBlendDstRgb, lastBlendSrcAlpha, lastBlendDstAlpha);
+    if (!lastBlend) {
+        glDisable(GL_BLEND);
+    }
+    if (lastScissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    if (lastDepth) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (lastCull) {
+        glEnable(GL_CULL_FACE);
+    }
+    glViewport(lastViewport[0], lastViewport[1], lastViewport[2], lastViewport[3]);
+
+    vertices.clear();
+    calls.clear();
+}
+
+size_t GLSpriteRenderer::getDrawCalls() const
+{
+    return lastDrawCalls;
+}
+
+size_t GLSpriteRenderer::getQuads() const
+{
+    return lastQuads;
+}
+
+uint32_t GLSpriteRenderer::compileShader(uint32_t type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[1024] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        SDL_Log("Cannot compile the sprite shader: %s", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
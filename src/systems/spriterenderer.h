@@ -0,0 +1,117 @@
+/*
+    spriterenderer.h: sprites drawn with plain gles2
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_spriterenderer_h
+#define _systems_spriterenderer_h
+
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+
+// a sprite that made it through culling, same meaning as the SDL_RenderCopyExF arguments
+struct DrawItem {
+    SDL_Rect source;
+    SDL_FRect destination;
+    double rotation;
+    SDL_RendererFlip flip;
+};
+
+// Draws sprites with plain gles2 calls instead of one SDL_RenderCopyExF each.
+// Every group of sprites with the same texture turns into four vertices per sprite in one shared
+// vertex buffer, which is uploaded once per flush, and then into a single draw call.
+// Gles2 has no instancing, so rotation and flips are baked into the vertices; that is still a lot
+// less than what SDL does per copy. Only works on top of the opengles2 and opengl SDL renderers,
+// and only draws to the window, not to render targets.
+class GLSpriteRenderer {
+public:
+    GLSpriteRenderer() = default;
+    ~GLSpriteRenderer();
+
+    GLSpriteRenderer(const GLSpriteRenderer&) = delete;
+    GLSpriteRenderer& operator=(const GLSpriteRenderer&) = delete;
+
+    // shaders and buffers, the renderers gl context has to be current. false if that does not work out
+    bool init(SDL_Renderer* renderer);
+    // gives the gl objects back, the context has to be still around
+    void release();
+    bool ready() const;
+
+    // Queues one group. texture is the gl texture name, format the SDL pixel format of the texture,
+    // the viewport is in renderer coordinates like with SDL_RenderSetViewport
+    void add(uint32_t texture, uint32_t width, uint32_t height, uint32_t format, const SDL_Rect& viewport, const DrawItem* items, size_t count);
+
+    // Static geometry, for things that dont change from frame to frame. The quads get a buffer of their own
+    // that stays until releaseBaked. 0 if that did not work out
+    uint32_t bake(uint32_t width, uint32_t height, const DrawItem* items, size_t count);
+    void releaseBaked(uint32_t buffer);
+    // queues quads from bake, moved by offset pixels. one draw call, unless there are a lot of quads
+    void addBaked(uint32_t buffer, size_t quads, uint32_t texture, uint32_t format, const SDL_Rect& viewport, float offsetX, float offsetY);
+    // Uploads everything queued and draws it. Whatever SDL has queued up until now is drawn first.
+    // The gl state SDL relies on is restored afterwards
+    void flush();
+
+    // what the last flush did, for the profiler and such
+    size_t getDrawCalls() const;
+    size_t getQuads() const;
+
+private:
+    struct Vertex {
+        float x;
+        float y;
+        float u;
+        float v;
+    };
+
+    struct DrawCall {
+        uint32_t texture;
+        SDL_Rect viewport;
+        // channel swaps for how SDL stored the texture
+        bool swapRedBlue;
+        bool opaque;
+        // 0 for the vertices uploaded in flush, a baked buffer otherwise
+        uint32_t buffer;
+        float offsetX;
+        float offsetY;
+        uint32_t firstVertex;
+        uint32_t quads;
+    };
+
+    // indices are 16 bit in gles2, so one draw call has at most that many quads
+    static constexpr uint32_t maxQuads = 65536 / 4;
+
+    static uint32_t compileShader(uint32_t type, const char* source);
+    static void writeQuads(const DrawItem* items, size_t count, uint32_t width, uint32_t height, Vertex* out);
+    // splits the call where the index buffer ends, and merges it into the last one where possible
+    void queue(DrawCall call);
+    void swizzle(uint32_t format, DrawCall& call) const;
+
+    SDL_Renderer* renderer = nullptr;
+    // the gles2 SDL renderer keeps argb and xrgb textures as they are and swaps channels in its shaders
+    bool swizzleTextures = false;
+
+    uint32_t program = 0;
+    uint32_t vertexBuffer = 0;
+    uint32_t indexBuffer = 0;
+    int32_t transformLocation = -1;
+    int32_t swizzleLocation = -1;
+    int32_t imageLocation = -1;
+
+    std::vector<Vertex> vertices;
+    std::vector<Vertex> bakeVertices;
+    std::vector<DrawCall> calls;
+    size_t lastDrawCalls = 0;
+    size_t lastQuads = 0;
+};
+
+#endif // _systems_spriterenderer_h
@@ -15,6 +15,9 @@
 #include "tick.h"
 
 #include "SDL.h"
+#include "runtime/profiler.h"
+#include <algorithm>
+#include <iterator>
 
 std::shared_ptr<TickSystem> TickSystem::instance(nullptr);
 
@@ -40,12 +43,38 @@ TickCallback& TickSystem::get(const IndexType& i)
 
 void TickSystem::remove(const IndexType& i)
 {
+    if (ticking && i == running) {
+        removeAfterTick.push_back(i);
+        return;
+    }
     tickCallbacks.remove(i);
 }
 
+void TickSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    if (ticking && std::find(indices.begin(), indices.end(), running) != indices.end()) {
+        // the running one waits, like in remove. everything else goes right away
+        removeAfterTick.push_back(running);
+        std::vector<IndexType> others;
+        others.reserve(indices.size());
+        std::remove_copy(indices.begin(), indices.end(), std::back_inserter(others), running);
+        tickCallbacks.removeMany(others);
+        return;
+    }
+    tickCallbacks.removeMany(indices);
+}
+
 void TickSystem::update(double dt)
 {
-    for (auto&& callback : tickCallbacks) {
+    // Callbacks can create or remove tick components while this runs. Values dont move in a SlotMap,
+    // so removing others is fine, only the running one has to stay alive until it returns.
+    // ones created now might tick already, if they land in a free slot
+    PROFILE_SCOPE("Python tick callbacks");
+    ticking = true;
+    auto end = tickCallbacks.end();
+    for (auto iter = tickCallbacks.begin(); iter != end; ++iter) {
+        const auto& callback = *iter;
+        running = iter.getGenerationIndex();
         try {
             if (callback) {
                 callback(dt);
@@ -54,6 +83,12 @@ void TickSystem::update(double dt)
             SDL_Log("Error while trying to tick %s", e.what());
         }
     }
+    ticking = false;
+
+    if (!removeAfterTick.empty()) {
+        tickCallbacks.removeMany(removeAfterTick);
+        removeAfterTick.clear();
+    }
 }
 
 void TickSystem::earlyCleanup()
@@ -16,6 +16,8 @@
 #define _systems_tick_h
 
 #include "component.h"
+#include "schedule.h"
+#include "util/slotmap.h"
 #include <functional>
 
 using TickCallback = std::function<void(double)>;
@@ -30,13 +32,21 @@ public:
     IndexType create(TickCallback callback);
     TickCallback& get(const IndexType& i);
     void remove(const IndexType& i);
+    void removeMany(const std::vector<IndexType>& indices);
 
+    // python callbacks
+    static constexpr SystemAccess access = { 0, StoreAll, true };
     void update(double dt);
     void earlyCleanup();
     static std::shared_ptr<TickSystem> instance;
 
 private:
+    // chunked, so python can hold on to a callback from get
     SlotMap<TickCallback> tickCallbacks;
+    // the callback that runs right now. removing that one waits until the loop is done
+    bool ticking = false;
+    IndexType running;
+    std::vector<IndexType> removeAfterTick;
 };
 
 using TickComponent = ComponentWrapper<TickSystem>;
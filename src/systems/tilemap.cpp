@@ -132,15 +132,27 @@ Tilemap& TilemapSystem::get(const IndexType& i)
 
 void TilemapSystem::remove(const IndexType& i)
 {
-    if (auto iter = tilemaps.find(i); iter != tilemaps.end()) {
-        for (auto&& batch : iter->batches) {
-            RenderSystem::instance->removeBatch(batch);
-        }
-        for (auto&& collider : iter->colliders) {
-            CollisionSystem::instance->remove(collider);
+    removeMany({ i });
+}
+
+void TilemapSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    std::vector<RenderSystem::BatchIndexType> batches;
+    std::vector<CollisionSystem::IndexType> colliders;
+    for (auto&& i : indices) {
+        if (auto iter = tilemaps.find(i); iter != tilemaps.end()) {
+            batches.insert(batches.end(), iter->batches.begin(), iter->batches.end());
+            colliders.insert(colliders.end(), iter->colliders.begin(), iter->colliders.end());
         }
     }
-    tilemaps.remove(i);
+    RenderSystem::instance->removeBatches(batches);
+    CollisionSystem::instance->removeMany(colliders);
+    tilemaps.removeMany(indices);
+
+    // a map takes a big chunk of the sprites and colliders with it
+    RenderSystem::instance->shrinkToFit();
+    CollisionSystem::instance->shrinkToFit();
+    tilemaps.shrinkToFit();
 }
 
 void TilemapSystem::update(double dt)
@@ -17,6 +17,7 @@
 
 #include "systems/collision.h"
 #include "systems/render.h"
+#include "systems/schedule.h"
 
 struct Tilemap {
     std::vector<CollisionSystem::IndexType> colliders;
@@ -32,7 +33,10 @@ public:
     IndexType create(const TransformSystem::IndexType& transformId, const std::string& filename);
     Tilemap& get(const IndexType& i);
     void remove(const IndexType& i);
+    // a level unload: all the batches and colliders go in one go, and memory is given back once
+    void removeMany(const std::vector<IndexType>& indices);
 
+    static constexpr SystemAccess access = { StoreTilemap, 0, false };
     void update(double dt);
 
     static std::shared_ptr<TilemapSystem> instance;
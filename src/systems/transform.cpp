@@ -16,6 +16,9 @@
 #include "transform.h"
 #include "python/python.h"
 
+#include <algorithm>
+#include <glm/glm.hpp>
+
 Transform2D::Transform2D()
     : position(0.0)
     , scale(1.0)
@@ -34,6 +37,15 @@ Transform2D::Transform2D(glm::vec2 p)
 {
 }
 
+Transform2DRef::Transform2DRef(glm::vec2& position, glm::vec2& scale, double& rotation, bool& flipHorizontal, bool& flipVertical)
+    : position(position)
+    , scale(scale)
+    , rotation(rotation)
+    , flipHorizontal(flipHorizontal)
+    , flipVertical(flipVertical)
+{
+}
+
 class PyTransform2D {
 public:
     static void initModule(py::module& m)
@@ -51,21 +63,232 @@ public:
 };
 PyType<Transform2D, PyTransform2D, glm::vec2> pytransform2d;
 
+class PyTransform2DRef {
+public:
+    static void initModule(py::module& m)
+    {
+        py::class_<Transform2DRef> c(m, "Transform2DRef");
+        c
+            .def_property(
+                "position",
+                [](Transform2DRef& t) -> glm::vec2& { return t.position; },
+                [](Transform2DRef& t, const glm::vec2& v) { t.position = v; },
+                py::return_value_policy::reference_internal)
+            .def_property(
+                "scale",
+                [](Transform2DRef& t) -> glm::vec2& { return t.scale; },
+                [](Transform2DRef& t, const glm::vec2& v) { t.scale = v; },
+                py::return_value_policy::reference_internal)
+            .def_property(
+                "rotation",
+                [](Transform2DRef& t) { return t.rotation; },
+                [](Transform2DRef& t, double v) { t.rotation = v; })
+            .def_property(
+                "flipHorizontal",
+                [](Transform2DRef& t) { return t.flipHorizontal; },
+                [](Transform2DRef& t, bool v) { t.flipHorizontal = v; })
+            .def_property(
+                "flipVertical",
+                [](Transform2DRef& t) { return t.flipVertical; },
+                [](Transform2DRef& t, bool v) { t.flipVertical = v; });
+    }
+};
+PyType<Transform2DRef, PyTransform2DRef, glm::vec2> pytransform2dref;
+
+TransformStorage::TransformStorage()
+{
+    chunks.emplace_back(new Chunk());
+}
+
+TransformStorage::IndexType TransformStorage::insert(const Transform2D& transform)
+{
+    IndexType i;
+    if (!freelist.empty()) {
+        i.index = freelist.back();
+        freelist.pop_back();
+    } else {
+        if (chunks.back()->size >= chunkSize) {
+            chunks.emplace_back(new Chunk());
+        }
+        auto& c = *chunks.back();
+        i.index = static_cast<uint32_t>((chunks.size() - 1) * chunkSize + c.size);
+        c.generations[c.size] = 0;
+        ++c.size;
+    }
+
+    auto& c = *chunks[i.index / chunkSize];
+    size_t offset = i.index % chunkSize;
+    c.positions[offset] = transform.position;
+    c.previousPositions[offset] = transform.position;
+    c.scales[offset] = transform.scale;
+    c.rotations[offset] = transform.rotation;
+    c.flips[offset].horizontal = transform.flipHorizontal;
+    c.flips[offset].vertical = transform.flipVertical;
+    c.alive[offset] = true;
+    i.generation = c.generations[offset];
+
+    return i;
+}
+
+void TransformStorage::remove(const IndexType& index)
+{
+    if (!valid(index)) {
+        return;
+    }
+
+    auto& c = *chunks[index.index / chunkSize];
+    size_t offset = index.index % chunkSize;
+    c.alive[offset] = false;
+    ++c.generations[offset];
+    freelist.push_back(index.index);
+}
+
+void TransformStorage::removeMany(const std::vector<IndexType>& indices)
+{
+    const std::vector<IndexType>* sorted = &indices;
+    std::vector<IndexType> copy;
+    if (!std::is_sorted(indices.begin(), indices.end())) {
+        copy = indices;
+        std::sort(copy.begin(), copy.end());
+        sorted = &copy;
+    }
+
+    freelist.reserve(freelist.size() + sorted->size());
+    // backwards, so the lowest index is reused first
+    for (auto index = sorted->rbegin(); index != sorted->rend(); ++index) {
+        if (!valid(*index)) {
+            continue;
+        }
+
+        auto& c = *chunks[index->index / chunkSize];
+        size_t offset = index->index % chunkSize;
+        c.alive[offset] = false;
+        ++c.generations[offset];
+        freelist.push_back(index->index);
+    }
+}
+
+bool TransformStorage::valid(const IndexType& index) const
+{
+    size_t chunkId = index.index / chunkSize;
+    if (chunkId >= chunks.size()) {
+        return false;
+    }
+
+    const auto& c = *chunks[chunkId];
+    size_t offset = index.index % chunkSize;
+    return offset < c.size && c.alive[offset] && c.generations[offset] == index.generation;
+}
+
+Transform2DRef TransformStorage::get(const IndexType& index)
+{
+    auto& c = *chunks[index.index / chunkSize];
+    size_t offset = index.index % chunkSize;
+    return Transform2DRef(
+        c.positions[offset],
+        c.scales[offset],
+        c.rotations[offset],
+        c.flips[offset].horizontal,
+        c.flips[offset].vertical);
+}
+
+glm::vec2& TransformStorage::position(const IndexType& index)
+{
+    return chunks[index.index / chunkSize]->positions[index.index % chunkSize];
+}
+
+void TransformStorage::savePrevious()
+{
+    for (auto&& c : chunks) {
+        std::copy(c->positions.begin(), c->positions.begin() + c->size, c->previousPositions.begin());
+    }
+}
+
+void TransformStorage::resetPrevious(const IndexType& index)
+{
+    if (valid(index)) {
+        auto& c = *chunks[index.index / chunkSize];
+        size_t offset = index.index % chunkSize;
+        c.previousPositions[offset] = c.positions[offset];
+    }
+}
+
+size_t TransformStorage::chunkCount() const
+{
+    return chunks.size();
+}
+
+TransformStorage::Chunk& TransformStorage::chunk(size_t i)
+{
+    return *chunks[i];
+}
+
+const TransformStorage::Chunk& TransformStorage::chunk(size_t i) const
+{
+    return *chunks[i];
+}
+
 std::shared_ptr<TransformSystem> TransformSystem::instance(nullptr);
 
 void TransformSystem::remove(const IndexType& index)
 {
-    positions.remove(index);
+    transforms.remove(index);
+}
+
+void TransformSystem::removeMany(const std::vector<IndexType>& indices)
+{
+    transforms.removeMany(indices);
 }
 
-Transform2D& TransformSystem::get(const IndexType& index)
+Transform2DRef TransformSystem::get(const IndexType& index)
 {
-    if (auto iter = positions.find(index); iter != positions.end()) {
-        return *iter;
+    if (transforms.valid(index)) {
+        return transforms.get(index);
     }
 
     defaultTransform = Transform2D();
-    return defaultTransform;
+    return Transform2DRef(
+        defaultTransform.position,
+        defaultTransform.scale,
+        defaultTransform.rotation,
+        defaultTransform.flipHorizontal,
+        defaultTransform.flipVertical);
+}
+
+glm::vec2& TransformSystem::getPosition(const IndexType& index)
+{
+    if (transforms.valid(index)) {
+        return transforms.position(index);
+    }
+
+    defaultTransform = Transform2D();
+    return defaultTransform.position;
+}
+
+glm::vec2 TransformSystem::getInterpolatedPosition(const IndexType& index) const
+{
+    if (!transforms.valid(index)) {
+        return glm::vec2(0.0f);
+    }
+
+    const auto& c = transforms.chunk(index.index / TransformStorage::chunkSize);
+    size_t offset = index.index % TransformStorage::chunkSize;
+    return glm::mix(c.previousPositions[offset], c.positions[offset], interpolation);
+}
+
+void TransformSystem::setInterpolation(float alpha)
+{
+    interpolation = alpha;
+}
+
+float TransformSystem::getInterpolation() const
+{
+    return interpolation;
+}
+
+TransformStorage& TransformSystem::getStorage()
+{
+    return transforms;
 }
 
 class PyTransformComponent {
@@ -76,8 +299,12 @@ public:
         c
             .def(py::init<>())
             .def(py::init<glm::vec2>())
-            .def("get", &TransformComponent::get, py::return_value_policy::reference);
+            .def("get", &TransformComponent::get, py::return_value_policy::reference)
+            // after setting the position by hand, so rendering does not slide over from the old one
+            .def("teleport", [](TransformComponent& component) {
+                TransformSystem::instance->getStorage().resetPrevious(component.getIndex());
+            });
     }
 };
-PyType<TransformComponent, PyTransformComponent, ComponentWrapperBase, Transform2D> pytransformcomponent;
+PyType<TransformComponent, PyTransformComponent, ComponentWrapperBase, Transform2D, Transform2DRef> pytransformcomponent;
 
@@ -16,7 +16,9 @@
 #define _position_h
 
 #include "util/slotmap.h"
+#include <array>
 #include <glm/vec2.hpp>
+#include <vector>
 
 #include "systems/component.h"
 
@@ -31,25 +33,101 @@ struct Transform2D {
     bool flipVertical;
 };
 
+// a single transform inside the TransformStorage.
+// references into chunk arrays, so they stay valid until the transform is removed
+struct Transform2DRef {
+    Transform2DRef(glm::vec2& position, glm::vec2& scale, double& rotation, bool& flipHorizontal, bool& flipVertical);
+
+    glm::vec2& position;
+    glm::vec2& scale;
+    double& rotation;
+    bool& flipHorizontal;
+    bool& flipVertical;
+};
+
+struct TransformFlip {
+    bool horizontal = false;
+    bool vertical = false;
+};
+
+// Transforms as struct of arrays.
+// Every member has its own array, so systems that only need positions dont pull in the rest.
+// Chunked like the SlotMap, so references stay stable and the index is a plain SlotMapIndex
+class TransformStorage {
+public:
+    using IndexType = SlotMapIndex;
+    static const size_t chunkSize = 256;
+
+    struct Chunk {
+        std::array<glm::vec2, chunkSize> positions;
+        // positions before the last fixed step, for interpolation. only the simulation moves things around
+        std::array<glm::vec2, chunkSize> previousPositions;
+        std::array<glm::vec2, chunkSize> scales;
+        std::array<double, chunkSize> rotations;
+        std::array<TransformFlip, chunkSize> flips;
+        std::array<uint32_t, chunkSize> generations;
+        std::array<bool, chunkSize> alive;
+        size_t size = 0;
+    };
+
+    TransformStorage();
+
+    IndexType insert(const Transform2D& transform);
+    void remove(const IndexType& index);
+    // sorted by index, the chunks are walked front to back
+    void removeMany(const std::vector<IndexType>& indices);
+    bool valid(const IndexType& index) const;
+
+    // no validity checks on these
+    Transform2DRef get(const IndexType& index);
+    glm::vec2& position(const IndexType& index);
+
+    // previousPositions = positions, before every fixed step
+    void savePrevious();
+    // no jump from the old position, for teleports
+    void resetPrevious(const IndexType& index);
+
+    // bulk access. slots that are not alive contain garbage
+    size_t chunkCount() const;
+    Chunk& chunk(size_t i);
+    const Chunk& chunk(size_t i) const;
+
+private:
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::vector<uint32_t> freelist;
+};
+
 class TransformSystem {
 public:
     using ComponentType = Transform2D;
-    using IndexType = SlotMap<Transform2D>::IndexType;
+    using IndexType = TransformStorage::IndexType;
 
     template <class... Args>
     IndexType create(Args&&... args)
     {
-        return positions.emplace(std::forward<Args>(args)...);
+        return transforms.insert(Transform2D(std::forward<Args>(args)...));
     }
 
     void remove(const IndexType& index);
-    Transform2D& get(const IndexType& index);
+    void removeMany(const std::vector<IndexType>& indices);
+    Transform2DRef get(const IndexType& index);
+    // only the position; cheaper if thats all you need
+    glm::vec2& getPosition(const IndexType& index);
+    // between the last two fixed steps, what rendering wants
+    glm::vec2 getInterpolatedPosition(const IndexType& index) const;
+
+    // how far the frame is between the previous and the current fixed step, 0 to 1
+    void setInterpolation(float alpha);
+    float getInterpolation() const;
+
+    TransformStorage& getStorage();
 
     static std::shared_ptr<TransformSystem> instance;
 
 private:
-    SlotMap<Transform2D> positions;
+    TransformStorage transforms;
     Transform2D defaultTransform;
+    float interpolation = 1.0f;
 };
 
 using TransformComponent = ComponentWrapper<TransformSystem>;
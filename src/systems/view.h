@@ -0,0 +1,161 @@
+/*
+    view.h: components joined with their transforms
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _systems_view_h
+#define _systems_view_h
+
+#include "systems/transform.h"
+#include "util/denseslotmap.h"
+#include "util/slotmap.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <vector>
+
+template <class A, class B>
+class View;
+
+// Every component of a store that has a live transform, with the transform already looked up.
+// Build it once per frame and iterate the rows instead of going through TransformSystem::get for every element.
+// The rows point right into the stores, so adding or removing components or transforms makes them stale
+// until the next build. Keep the view around between frames, the row array is reused.
+// Component needs a transformId member.
+template <class Component>
+class View<Transform2D, Component> {
+public:
+    struct Row {
+        Component* component;
+        SlotMapIndex index;
+        uint32_t transformIndex;
+        TransformStorage::Chunk* chunk;
+        size_t slot;
+
+        glm::vec2& position() const
+        {
+            return chunk->positions[slot];
+        }
+
+        // between the last two fixed steps
+        glm::vec2 interpolatedPosition(float alpha) const
+        {
+            return glm::mix(chunk->previousPositions[slot], chunk->positions[slot], alpha);
+        }
+
+        glm::vec2& scale() const
+        {
+            return chunk->scales[slot];
+        }
+
+        double& rotation() const
+        {
+            return chunk->rotations[slot];
+        }
+
+        TransformFlip& flip() const
+        {
+            return chunk->flips[slot];
+        }
+
+        Transform2DRef transform() const
+        {
+            return Transform2DRef(chunk->positions[slot], chunk->scales[slot], chunk->rotations[slot], chunk->flips[slot].horizontal, chunk->flips[slot].vertical);
+        }
+    };
+    using Rows = std::vector<Row>;
+    using iterator = typename Rows::iterator;
+
+    // sortByTransform walks the transforms in memory order afterwards,
+    // worth it for stores that write transforms. it changes the iteration order though
+    template <size_t baseSize>
+    void build(SlotMap<Component, baseSize>& store, TransformStorage& transforms, bool sortByTransform = false)
+    {
+        rows.clear();
+        for (auto iter = store.begin(); iter != store.end(); ++iter) {
+            add(*iter, iter.getGenerationIndex(), transforms);
+        }
+        finish(sortByTransform);
+    }
+
+    void build(DenseSlotMap<Component>& store, TransformStorage& transforms, bool sortByTransform = false)
+    {
+        rows.clear();
+        for (size_t i = 0; i < store.size(); i++) {
+            add(store.data()[i], store.indexAt(i), transforms);
+        }
+        finish(sortByTransform);
+    }
+
+    iterator begin()
+    {
+        return rows.begin();
+    }
+
+    iterator end()
+    {
+        return rows.end();
+    }
+
+    size_t size() const
+    {
+        return rows.size();
+    }
+
+    Row& operator[](size_t i)
+    {
+        return rows[i];
+    }
+
+    // same rules as DenseSlotMap::parallelForEach
+    template <class Pool, class Fn>
+    void parallelForEach(Pool& pool, Fn&& fn, size_t blockSize = 256)
+    {
+        size_t count = rows.size();
+        pool.parallelFor((count + blockSize - 1) / blockSize, [this, &fn, count, blockSize](size_t block) {
+            size_t last = std::min(count, (block + 1) * blockSize);
+            for (size_t i = block * blockSize; i < last; i++) {
+                fn(rows[i]);
+            }
+        });
+    }
+
+private:
+    void add(Component& component, const SlotMapIndex& index, TransformStorage& transforms)
+    {
+        const auto& transformId = component.transformId;
+        if (!transforms.valid(transformId)) {
+            return;
+        }
+
+        Row row;
+        row.component = &component;
+        row.index = index;
+        row.transformIndex = transformId.index;
+        row.chunk = &transforms.chunk(transformId.index / TransformStorage::chunkSize);
+        row.slot = transformId.index % TransformStorage::chunkSize;
+        rows.push_back(row);
+    }
+
+    void finish(bool sortByTransform)
+    {
+        if (sortByTransform) {
+            std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+                return a.transformIndex < b.transformIndex;
+            });
+        }
+    }
+
+    Rows rows;
+};
+
+#endif // _systems_view_h
\ No newline at end of file
@@ -0,0 +1,266 @@
+/*
+    denseslotmap.h: a slot map with densely packed values
+    Copyright (C) 2019 Malte Kieling
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _denseslotmap_h
+#define _denseslotmap_h
+
+#include "util/slotmap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Same interface as SlotMap, but the values live in one contiguous array.
+// A sparse slot array maps the (generation checked) SlotMapIndex to the position
+// of the value in the dense array. Removal swaps the last value into the hole.
+// Use this for stores that are iterated every frame.
+// Careful: adding or removing values moves other values around,
+// so pointers and references into the map do not survive that.
+template <class T>
+class DenseSlotMap {
+public:
+    using DataType = T;
+    using IndexType = SlotMapIndex;
+    using ValueArray = std::vector<T>;
+    using iterator = typename ValueArray::iterator;
+    using const_iterator = typename ValueArray::const_iterator;
+
+    static const uint32_t invalidPosition = 0xFFFFFFFF;
+
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t position = invalidPosition;
+    };
+
+    iterator begin()
+    {
+        return values.begin();
+    }
+
+    iterator end()
+    {
+        return values.end();
+    }
+
+    const_iterator begin() const
+    {
+        return values.begin();
+    }
+
+    const_iterator end() const
+    {
+        return values.end();
+    }
+
+    size_t size() const
+    {
+        return values.size();
+    }
+
+    bool empty() const
+    {
+        return values.empty();
+    }
+
+    // the raw dense array. valid until the next insert or remove
+    T* data()
+    {
+        return values.data();
+    }
+
+    const T* data() const
+    {
+        return values.data();
+    }
+
+    // Calls fn on every value, spread over the pool in blocks of blockSize values.
+    // Same rules as SlotMap::parallelForEach: no insert or remove while this runs,
+    // and fn must not touch anything another value might touch too.
+    template <class Pool, class Fn>
+    void parallelForEach(Pool& pool, Fn&& fn, size_t blockSize = 256)
+    {
+        size_t count = values.size();
+        pool.parallelFor((count + blockSize - 1) / blockSize, [this, &fn, count, blockSize](size_t block) {
+            size_t last = std::min(count, (block + 1) * blockSize);
+            for (size_t i = block * blockSize; i < last; i++) {
+                fn(values[i]);
+            }
+        });
+    }
+
+    template <class Pool, class Fn>
+    void parallelForEach(Pool& pool, Fn&& fn, size_t blockSize = 256) const
+    {
+        size_t count = values.size();
+        pool.parallelFor((count + blockSize - 1) / blockSize, [this, &fn, count, blockSize](size_t block) {
+            size_t last = std::min(count, (block + 1) * blockSize);
+            for (size_t i = block * blockSize; i < last; i++) {
+                fn(static_cast<const T&>(values[i]));
+            }
+        });
+    }
+
+    // the index of the value at a position in the dense array
+    IndexType indexAt(size_t position) const
+    {
+        IndexType i;
+        i.index = owners[position];
+        i.generation = slots[i.index].generation;
+        return i;
+    }
+
+    T& operator[](const IndexType& index)
+    {
+        return values[slots[index.index].position];
+    }
+
+    T& operator[](uint64_t intIndex)
+    {
+        IndexType index(intIndex);
+        return values[slots[index.index].position];
+    }
+
+    iterator find(const IndexType& index)
+    {
+        if (index.index >= slots.size()) {
+            return end();
+        }
+
+        auto& slot = slots[index.index];
+        if (slot.position == invalidPosition || slot.generation != index.generation) {
+            return end();
+        }
+
+        return values.begin() + slot.position;
+    }
+
+    // the value goes in first, so a throwing copy or constructor leaves the map as it was
+    IndexType insert(const T& value)
+    {
+        values.push_back(value);
+        return allocateSlot();
+    }
+
+    IndexType insert(T&& value)
+    {
+        values.push_back(std::move(value));
+        return allocateSlot();
+    }
+
+    template <typename... Args>
+    IndexType emplace(Args&&... args)
+    {
+        values.emplace_back(std::forward<Args>(args)...);
+        return allocateSlot();
+    }
+
+    void remove(const IndexType& index)
+    {
+        if (find(index) == end()) {
+            return;
+        }
+
+        removeAt(slots[index.index].position);
+    }
+
+    // A whole batch at once. Goes from the back of the array to the front, so every element
+    // that gets swapped into a hole is one that stays, and nothing is moved twice. Stale indices are skipped.
+    void removeMany(const std::vector<IndexType>& indices)
+    {
+        std::vector<uint32_t> positions;
+        positions.reserve(indices.size());
+        for (auto&& index : indices) {
+            if (find(index) != end()) {
+                positions.push_back(slots[index.index].position);
+            }
+        }
+
+        std::sort(positions.begin(), positions.end(), std::greater<uint32_t>());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        freelist.reserve(freelist.size() + positions.size());
+        for (auto&& position : positions) {
+            removeAt(position);
+        }
+    }
+
+    void clear()
+    {
+        for (auto&& owner : owners) {
+            auto& slot = slots[owner];
+            ++slot.generation;
+            slot.position = invalidPosition;
+            freelist.push_back(owner);
+        }
+        values.clear();
+        owners.clear();
+    }
+
+private:
+    void removeAt(uint32_t position)
+    {
+        uint32_t slotIndex = owners[position];
+        auto& slot = slots[slotIndex];
+        uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        // swap and pop
+        if (position != last) {
+            values[position] = std::move(values[last]);
+            owners[position] = owners[last];
+            slots[owners[position]].position = position;
+        }
+        values.pop_back();
+        owners.pop_back();
+
+        ++slot.generation;
+        slot.position = invalidPosition;
+        freelist.push_back(slotIndex);
+    }
+
+    // A slot for the value that was just added at the back.
+    // If there is no memory for it, the value goes again and nothing else changed
+    IndexType allocateSlot()
+    {
+        IndexType i;
+        bool fresh = freelist.empty();
+        i.index = fresh ? static_cast<uint32_t>(slots.size()) : freelist.back();
+        try {
+            owners.push_back(i.index);
+            if (fresh) {
+                slots.emplace_back();
+            }
+        } catch (...) {
+            if (owners.size() > values.size() - 1) {
+                owners.pop_back();
+            }
+            values.pop_back();
+            throw;
+        }
+        if (!fresh) {
+            freelist.pop_back();
+        }
+
+        auto& slot = slots[i.index];
+        slot.position = static_cast<uint32_t>(values.size() - 1);
+        i.generation = slot.generation;
+
+        return i;
+    }
+
+    ValueArray values;
+    std::vector<uint32_t> owners; // dense position -> slot
+    std::vector<Slot> slots; // slot -> dense position
+    std::vector<uint32_t> freelist;
+};
+
+#endif //_denseslotmap_h
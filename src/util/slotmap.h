@@ -15,12 +15,19 @@
 #ifndef _slotmap_h
 #define _slotmap_h
 
+#include <algorithm>
 #include <array>
+#include <bitset>
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 struct SlotMapIndex {
     SlotMapIndex() = default;
     SlotMapIndex(uint64_t intIndex)
@@ -65,23 +72,44 @@ template <class T, size_t baseSize = 256>
 class SlotMap {
 public:
     using DataType = T;
-    struct StorageType {
-        StorageType()
-            : free(false)
-            , generation(0)
-            , data()
-            , ptr(reinterpret_cast<T*>(&data))
-        {
-        }
-        bool free;
-        uint32_t generation;
-        typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
-        T* ptr;
-    };
+    using StorageType = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    static const size_t maskWords = (baseSize + 63) / 64;
+    // generations live next to, not inside, the payload.
+    // an odd generation marks a free slot, so there is no extra flag to pad around
+    // occupied mirrors that as one bit per slot, so iteration can jump over free slots
     struct Chunk {
+        std::array<uint64_t, maskWords> occupied = {};
+        std::array<uint32_t, baseSize> generations;
         std::array<StorageType, baseSize> data;
         size_t size = 0;
     };
+
+    static bool isFree(uint32_t generation)
+    {
+        return (generation & 1) != 0;
+    }
+
+    static uint32_t lowestBit(uint64_t bits)
+    {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward64(&i, bits);
+        return static_cast<uint32_t>(i);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+    }
+
+    static uint32_t highestBit(uint64_t bits)
+    {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanReverse64(&i, bits);
+        return static_cast<uint32_t>(i);
+#else
+        return static_cast<uint32_t>(63 - __builtin_clzll(bits));
+#endif
+    }
     using ChunkArray = std::vector<std::unique_ptr<Chunk>>;
     using FreeList = std::vector<int>;
     using IndexType = SlotMapIndex;
@@ -94,52 +122,37 @@ public:
         using reference = T&;
 
         iterator() {}
-        iterator(const ChunkArray* storage, uint32_t index, int inc = 1)
+        iterator(const ChunkArray* storage, uint32_t index, uint32_t maxIndex, int inc = 1)
             : storage(storage)
             , index(index)
+            , maxIndex(maxIndex)
             , inc(inc)
         {
         }
 
         iterator& operator++()
         {
-            auto maxIndex = baseSize * (storage->size() - 1) + storage->back()->size;
-            do {
-                index += inc;
-            } while (
-                index >= 0 && index < maxIndex && (*storage)[index / baseSize]->data[index % baseSize].free);
+            step(inc);
             return *this;
         }
 
         iterator operator++(int)
         {
             auto t = *this;
-            auto maxIndex = baseSize * (storage->size() - 1) + storage->back()->size;
-            do {
-                index += inc;
-            } while (
-                index >= 0 && index < maxIndex && (*storage)[index / baseSize]->data[index % baseSize].free);
+            step(inc);
             return t;
         }
 
         iterator& operator--()
         {
-            auto maxIndex = baseSize * (storage->size() - 1) + storage->back()->size;
-            do {
-                index -= inc;
-            } while (
-                index >= 0 && index < maxIndex && (*storage)[index / baseSize]->data[index % baseSize].free);
+            step(-inc);
             return *this;
         }
 
         iterator operator--(int)
         {
             auto t = *this;
-            auto maxIndex = baseSize * (storage->size() - 1) + storage->back()->size;
-            do {
-                index -= inc;
-            } while (
-                index >= 0 && index < maxIndex && (*storage)[index / baseSize]->data[index % baseSize].free);
+            step(-inc);
             return t;
         }
 
@@ -178,24 +191,29 @@ public:
 
         T& operator*()
         {
-            return *reinterpret_cast<T*>(&(*storage)[index / baseSize]->data[index % baseSize].data);
+            return *reinterpret_cast<T*>(&getStorage());
         }
 
         T* operator->()
         {
-            return reinterpret_cast<T*>(&(*storage)[index / baseSize]->data[index % baseSize].data);
+            return reinterpret_cast<T*>(&getStorage());
         }
 
-        StorageType& getTag() const
+        StorageType& getStorage() const
         {
             return (*storage)[index / baseSize]->data[index % baseSize];
         }
 
+        uint32_t& getGeneration() const
+        {
+            return (*storage)[index / baseSize]->generations[index % baseSize];
+        }
+
         IndexType getGenerationIndex() const
         {
             IndexType i;
             i.index = index;
-            i.generation = getTag().generation;
+            i.generation = getGeneration();
             return i;
         }
 
@@ -205,11 +223,90 @@ public:
         }
 
     private:
+        void step(int direction)
+        {
+            if (direction > 0) {
+                // dense maps mostly have the very next slot in use
+                ++index;
+                if (index < maxIndex && isUsed(*storage, index)) {
+                    return;
+                }
+                index = nextUsed(*storage, index, maxIndex);
+            } else {
+                index = previousUsed(*storage, index - 1, maxIndex);
+            }
+        }
+
         const ChunkArray* storage;
         uint32_t index;
+        uint32_t maxIndex;
         int inc;
     };
 
+    static bool isUsed(const ChunkArray& storage, uint32_t index)
+    {
+        auto slot = index % baseSize;
+        return (storage[index / baseSize]->occupied[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    // first used slot at or after from, maxIndex if there is none
+    static uint32_t nextUsed(const ChunkArray& storage, uint32_t from, uint32_t maxIndex)
+    {
+        while (from < maxIndex) {
+            const Chunk& chunk = *storage[from / baseSize];
+            uint32_t chunkStart = from - from % baseSize;
+            size_t word = (from % baseSize) / 64;
+            uint64_t bits = chunk.occupied[word] & (~0ull << (from % baseSize % 64));
+            for (;;) {
+                if (bits) {
+                    uint32_t found = chunkStart + static_cast<uint32_t>(word * 64) + lowestBit(bits);
+                    return found < maxIndex ? found : maxIndex;
+                }
+                if (++word >= maskWords) {
+                    break;
+                }
+                bits = chunk.occupied[word];
+            }
+            // nothing left in this chunk
+            from = chunkStart + baseSize;
+        }
+
+        return maxIndex;
+    }
+
+    // last used slot at or before from, -1 if there is none
+    static uint32_t previousUsed(const ChunkArray& storage, uint32_t from, uint32_t maxIndex)
+    {
+        const uint32_t none = static_cast<uint32_t>(-1);
+        if (maxIndex == 0 || from == none) {
+            return none;
+        }
+        if (from >= maxIndex) {
+            from = maxIndex - 1;
+        }
+
+        for (;;) {
+            const Chunk& chunk = *storage[from / baseSize];
+            uint32_t chunkStart = from - from % baseSize;
+            size_t word = (from % baseSize) / 64;
+            uint32_t bit = from % baseSize % 64;
+            uint64_t bits = chunk.occupied[word] & (bit == 63 ? ~0ull : (1ull << (bit + 1)) - 1);
+            for (;;) {
+                if (bits) {
+                    return chunkStart + static_cast<uint32_t>(word * 64) + highestBit(bits);
+                }
+                if (word == 0) {
+                    break;
+                }
+                bits = chunk.occupied[--word];
+            }
+            if (chunkStart == 0) {
+                return none;
+            }
+            from = chunkStart - 1;
+        }
+    }
+
     SlotMap()
     {
         freelist.reserve(baseSize);
@@ -224,67 +321,139 @@ public:
         data.clear();
     }
 
-    iterator begin() const
+    // Moving takes the chunks along and allocates nothing. The moved from map has no chunk at all,
+    // it is empty but still usable, like a new one.
+    // Iterators into the moved from map do not follow, pointers to elements do
+    SlotMap(SlotMap&& other) noexcept
+        : data(std::move(other.data))
+        , currentChunk(other.currentChunk)
+        , freelist(std::move(other.freelist))
+        , generationFloor(other.generationFloor)
+    {
+        other.data.clear();
+        other.currentChunk = 0;
+        other.freelist.clear();
+    }
+
+    SlotMap& operator=(SlotMap&& other) noexcept
     {
-        iterator iter(&data, 0, 1);
-        if (iter.getTag().free) {
-            iter++; // automatically goes to first free or end()
+        if (this == &other) {
+            return *this;
         }
 
-        return iter;
+        clear();
+        data = std::move(other.data);
+        currentChunk = other.currentChunk;
+        freelist = std::move(other.freelist);
+        generationFloor = other.generationFloor;
+        other.data.clear();
+        other.currentChunk = 0;
+        other.freelist.clear();
+        return *this;
+    }
+
+    void swap(SlotMap& other) noexcept
+    {
+        std::swap(data, other.data);
+        std::swap(currentChunk, other.currentChunk);
+        std::swap(freelist, other.freelist);
+        std::swap(generationFloor, other.generationFloor);
+    }
+
+    iterator begin() const
+    {
+        return iterator(&data, nextUsed(data, 0, endIndex()), endIndex(), 1);
     }
 
     iterator end() const
     {
-        return iterator(&data, static_cast<uint32_t>(currentChunk * baseSize + data[currentChunk]->size), 1);
+        return iterator(&data, endIndex(), endIndex(), 1);
     }
 
     iterator rbegin() const
     {
-
-        iterator iter(&data, currentChunk * baseSize + data[currentChunk]->size, -1);
-        if (iter.getTag().free) {
-            iter++; // automatically goes to first free or end()
-        }
+        iterator iter(&data, endIndex(), endIndex(), -1);
+        iter++; // goes to the last used element or rend()
 
         return iter;
     }
 
     iterator rend() const
     {
-        iterator iter(&data, -1, 1);
+        iterator iter(&data, -1, endIndex(), 1);
         return iter;
     }
 
+    bool empty() const
+    {
+        return begin() == end();
+    }
+
+    // number of used slots
+    size_t size() const
+    {
+        size_t count = 0;
+        for (auto&& chunk : data) {
+            for (auto&& word : chunk->occupied) {
+                count += std::bitset<64>(word).count();
+            }
+        }
+        return count;
+    }
+
+    // Calls fn on every used element, spread over the pool one chunk at a time.
+    // No chunk is visited by two workers, but fn runs concurrently for different elements,
+    // so it must not touch anything another element might touch too.
+    // Dont insert or remove while this runs.
+    template <class Pool, class Fn>
+    void parallelForEach(Pool& pool, Fn&& fn)
+    {
+        pool.parallelFor(data.empty() ? 0 : currentChunk + 1, [this, &fn](size_t chunkIndex) {
+            forEachInChunk(*data[chunkIndex], [&fn](StorageType& slot) {
+                fn(*reinterpret_cast<T*>(&slot));
+            });
+        });
+    }
+
+    template <class Pool, class Fn>
+    void parallelForEach(Pool& pool, Fn&& fn) const
+    {
+        pool.parallelFor(data.empty() ? 0 : currentChunk + 1, [this, &fn](size_t chunkIndex) {
+            forEachInChunk(*data[chunkIndex], [&fn](StorageType& slot) {
+                fn(*reinterpret_cast<const T*>(&slot));
+            });
+        });
+    }
+
     T& operator[](const IndexType& index)
     {
-        return *reinterpret_cast<T*>(&data[index.index / baseSize]->data[index.index % baseSize].data);
+        return *reinterpret_cast<T*>(&data[index.index / baseSize]->data[index.index % baseSize]);
     }
     T& operator[](uint64_t intIndex)
     {
         IndexType index(intIndex);
-        return *reinterpret_cast<T*>(&data[index.index / baseSize]->data[index.index % baseSize].data);
+        return *reinterpret_cast<T*>(&data[index.index / baseSize]->data[index.index % baseSize]);
     }
 
     iterator find(const IndexType& index) const
     {
-        if (index.index >= currentChunk * baseSize + data[currentChunk]->size) {
+        if (index.index >= endIndex()) {
             return end();
         }
 
-        auto& tag = data[index.index / baseSize]->data[index.index % baseSize];
-        if (tag.free || tag.generation != index.generation) {
+        auto generation = data[index.index / baseSize]->generations[index.index % baseSize];
+        if (isFree(generation) || generation != index.generation) {
             return end();
         }
 
-        return iterator(&data, index.index, 1);
+        return iterator(&data, index.index, endIndex(), 1);
     }
 
     IndexType insert(const T& value)
     {
 
         iterator iter = allocateTag();
-        new (&iter.getTag().data) T(value);
+        new (&iter.getStorage()) T(value);
 
         return iter.getGenerationIndex();
     }
@@ -292,7 +461,7 @@ public:
     IndexType insert(T&& value)
     {
         iterator iter = allocateTag();
-        new (&iter.getTag().data) T(std::move(value));
+        new (&iter.getStorage()) T(std::move(value));
         return iter.getGenerationIndex();
     }
 
@@ -300,7 +469,7 @@ public:
     IndexType emplace(Args&&... args)
     {
         iterator iter = allocateTag();
-        new (&iter.getTag().data) T(std::forward<Args>(args)...);
+        new (&iter.getStorage()) T(std::forward<Args>(args)...);
         return iter.getGenerationIndex();
     }
 
@@ -311,26 +480,49 @@ public:
             return;
         }
 
-        auto& tag = iter.getTag();
-        reinterpret_cast<T*>(&tag.data)->~T();
-        ++tag.generation;
-        tag.free = true;
+        reinterpret_cast<T*>(&iter.getStorage())->~T();
+        ++iter.getGeneration();
+        markFree(iter.getRawIndex());
         freelist.push_back(iter.getRawIndex());
     }
 
+    // A whole batch at once (map unloads, entity teardown). The freelist grows once, then the slots
+    // are freed in the given order like remove would. Stale indices are skipped.
+    void removeMany(const std::vector<IndexType>& indices)
+    {
+        freelist.reserve(freelist.size() + indices.size());
+        for (auto&& index : indices) {
+            auto iter = find(index);
+            if (iter == end()) {
+                continue;
+            }
+
+            reinterpret_cast<T*>(&iter.getStorage())->~T();
+            ++iter.getGeneration();
+            markFree(iter.getRawIndex());
+            freelist.push_back(iter.getRawIndex());
+        }
+    }
+
     void clear()
     {
         for (auto&& chunk : data) {
             for (size_t i = 0; i < chunk->size; i++) {
-                auto& elem = chunk->data[i];
-                if (!elem.free) {
-                    reinterpret_cast<T*>(&elem.data)->~T();
+                if (!isFree(chunk->generations[i])) {
+                    reinterpret_cast<T*>(&chunk->data[i])->~T();
                 }
+                // so old indices wont match whatever lands in this slot next
+                raiseGenerationFloor(chunk->generations[i]);
             }
             // simple set size to 0
             chunk->size = 0;
+            chunk->occupied.fill(0);
         }
 
+        // keep the first chunk around, the rest can go. a moved from map has none to keep
+        if (!data.empty()) {
+            data.resize(1);
+        }
         currentChunk = 0;
         freelist.clear();
         freelist.reserve(baseSize);
@@ -343,44 +535,127 @@ public:
     {
         for (auto&& chunk : data) {
             chunk->size = 0;
+            chunk->occupied.fill(0);
         }
 
         currentChunk = 0;
         freelist.clear();
     }
 
+    // Drops free slots at the end and releases chunks that are empty after that.
+    // Nothing moves, so all indices stay valid.
+    // Freed slots get reused lowest index first afterwards, which keeps the map packed at the front.
+    void shrinkToFit()
+    {
+        if (data.empty()) {
+            return;
+        }
+
+        uint32_t last = endIndex();
+        while (last > 0 && isFree(generationAt(last - 1))) {
+            raiseGenerationFloor(generationAt(last - 1));
+            --last;
+        }
+
+        currentChunk = last == 0 ? 0 : (last - 1) / baseSize;
+        data.resize(currentChunk + 1);
+        data[currentChunk]->size = last - currentChunk * baseSize;
+
+        freelist.clear();
+        for (uint32_t i = last; i > 0; i--) {
+            if (isFree(generationAt(i - 1))) {
+                freelist.push_back(static_cast<int>(i - 1));
+            }
+        }
+        freelist.shrink_to_fit();
+    }
+
 protected:
     iterator allocateTag()
     {
         if (!freelist.empty()) {
-            iterator iter(&data, freelist.back());
+            iterator iter(&data, freelist.back(), endIndex());
             freelist.pop_back();
-            iter.getTag().free = false;
+            ++iter.getGeneration();
+            markUsed(iter.getRawIndex());
             return iter;
         }
 
-        // chunk full?
-        if (data[currentChunk]->size >= baseSize) {
+        // moved from maps start over with their first chunk
+        if (data.empty()) {
             data.emplace_back(new Chunk());
+            currentChunk = 0;
+        }
+
+        // chunk full? (after a fastClear the next one is still around)
+        if (data[currentChunk]->size >= baseSize) {
             ++currentChunk;
+            if (currentChunk >= data.size()) {
+                data.emplace_back(new Chunk());
+            }
         }
 
         auto& chunk = data[currentChunk];
 
         // return new tag
-        auto& tag = chunk->data[chunk->size];
-        iterator iter(&data, static_cast<uint32_t>((data.size() - 1) * baseSize + chunk->size));
-        ++data[currentChunk]->size;
-        // placement new the data tag
-        new (&tag) StorageType();
+        chunk->generations[chunk->size] = generationFloor;
+        uint32_t index = static_cast<uint32_t>(currentChunk * baseSize + chunk->size);
+        ++chunk->size;
+        markUsed(index);
 
-        return iter;
+        return iterator(&data, index, endIndex());
+    }
+
+    uint32_t endIndex() const
+    {
+        if (data.empty()) {
+            return 0;
+        }
+        return static_cast<uint32_t>(currentChunk * baseSize + data[currentChunk]->size);
+    }
+
+    uint32_t& generationAt(uint32_t index)
+    {
+        return data[index / baseSize]->generations[index % baseSize];
+    }
+
+    template <class Fn>
+    static void forEachInChunk(Chunk& chunk, Fn&& fn)
+    {
+        for (size_t word = 0; word < maskWords; word++) {
+            for (uint64_t bits = chunk.occupied[word]; bits; bits &= bits - 1) {
+                fn(chunk.data[word * 64 + lowestBit(bits)]);
+            }
+        }
+    }
+
+    void markUsed(uint32_t index)
+    {
+        auto slot = index % baseSize;
+        data[index / baseSize]->occupied[slot / 64] |= 1ull << (slot % 64);
+    }
+
+    void markFree(uint32_t index)
+    {
+        auto slot = index % baseSize;
+        data[index / baseSize]->occupied[slot / 64] &= ~(1ull << (slot % 64));
+    }
+
+    // slots that are handed out fresh start at this generation
+    void raiseGenerationFloor(uint32_t generation)
+    {
+        // always even, so fresh slots are in use
+        uint32_t next = (generation | 1) + 1;
+        if (next > generationFloor) {
+            generationFloor = next;
+        }
     }
 
 private:
     ChunkArray data;
     size_t currentChunk;
     FreeList freelist;
+    uint32_t generationFloor = 0;
 };
 
 #endif //_slotmap_h
\ No newline at end of file
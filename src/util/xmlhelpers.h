@@ -1,5 +1,5 @@
 #ifndef _util_xmlhelpers_h
-#define _utul_xmlhelpers_h
+#define _util_xmlhelpers_h
 
 #include <string>
 #include <tinyxml2.h>